@@ -0,0 +1,414 @@
+#include "JobManager.h"
+#include "DeviceMemoryAllocator.h"
+
+#include "utils.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <random>
+
+
+// Microbenchmarks of the hot paths of the library. Every benchmark runs once per memory
+// allocator with a fixed number of iterations and fixed input data, host times are
+// measured around the operation and GPU times are taken from the timestamp queries of the
+// jobs (see JobManagerSettings::enableProfiling). Results are printed and saved as JSON.
+//
+// Usage: gpujob_bench [--iterations N] [--warmup N] [--allocator simple|vma|all]
+//                     [--filter SUBSTRING] [--json PATH]
+//
+// Has to be run from the build directory, like the tests, so that shaders are found.
+
+namespace
+{
+    struct Options
+    {
+        size_t iterations = 20;
+        size_t warmup = 3;
+        std::string allocator = "all";
+        std::string filter;
+        std::string jsonPath = "gpujob_bench.json";
+    };
+
+    // times of a single iteration in microseconds, negative GPU time if it was not measured
+    struct Sample
+    {
+        float hostTime = 0;
+        float gpuTime = -1;
+    };
+
+    struct Case
+    {
+        std::string name;
+        std::string allocator;
+        // number of bytes processed by a single iteration, 0 if bandwidth is meaningless
+        size_t bytes = 0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    float elapsedMicroseconds(Clock::time_point start)
+    {
+        return std::chrono::duration<float, std::micro>(Clock::now() - start).count();
+    }
+
+    std::string sizeName(size_t size)
+    {
+        if (size >= 1024 * 1024)
+            return std::to_string(size / (1024 * 1024)) + "MiB";
+        return std::to_string(size / 1024) + "KiB";
+    }
+
+    std::string bufferTypeName(Buffer::Type type)
+    {
+        switch (type)
+        {
+        case Buffer::Type::DeviceLocal: return "DeviceLocal";
+        case Buffer::Type::Staging: return "Staging";
+        case Buffer::Type::Uniform: return "Uniform";
+        case Buffer::Type::DeviceMapped: return "DeviceMapped";
+        }
+        return "Unknown";
+    }
+
+    // submits already recorded job and waits for it, GPU time is the sum of the profiled
+    // operations of the category (all operations if it is empty)
+    Sample runJob(Job &job, const std::string &category = {})
+    {
+        auto start = Clock::now();
+        job.submit();
+        if (!job.await())
+            throw std::runtime_error("Benchmark job failed");
+
+        Sample sample;
+        sample.hostTime = elapsedMicroseconds(start);
+        double gpuTime = 0;
+        bool measured = false;
+        for (const auto &record : job.getProfilingResults())
+        {
+            if (!category.empty() && record.category != category)
+                continue;
+            gpuTime += record.duration / 1000.0;
+            measured = true;
+        }
+        if (measured)
+            sample.gpuTime = static_cast<float>(gpuTime);
+
+        return sample;
+    }
+
+    class Benchmarks
+    {
+        const Options &options;
+        std::vector<Case> cases;
+
+    public:
+        Benchmarks(const Options &options) :
+            options(options)
+        {}
+
+        const std::vector<Case>& getCases() const { return cases; }
+
+        void run(const std::string &allocator, const std::string &name, size_t bytes,
+            const std::function<Sample()> &iteration)
+        {
+            std::string key = allocator + "/" + name;
+            if (!options.filter.empty() && key.find(options.filter) == std::string::npos)
+                return;
+
+            for (size_t i = 0; i < options.warmup; ++i)
+                iteration();
+            for (size_t i = 0; i < options.iterations; ++i)
+            {
+                Sample sample = iteration();
+                addMeasure(key + "/host", sample.hostTime);
+                if (sample.gpuTime >= 0)
+                    addMeasure(key + "/gpu", sample.gpuTime);
+            }
+            cases.push_back({ name, allocator, bytes });
+        }
+    };
+
+    std::vector<uint32_t> makeInput(size_t count, uint32_t range)
+    {
+        // fixed seed keeps the input identical between runs
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<uint32_t> dis(0, range - 1);
+        std::vector<uint32_t> data(count);
+        for (auto &value : data)
+            value = dis(gen);
+
+        return data;
+    }
+
+    VkPhysicalDeviceProperties runSuite(Benchmarks &benchmarks, const std::string &allocatorName, DeviceMemoryAllocator *allocator)
+    {
+        JobManagerSettings settings;
+        settings.enableProfiling = true;
+        JobManager manager({}, allocator, settings);
+        if (!manager.isProfilingEnabled())
+            std::cout << "Timestamps are not supported, only host times are measured\n";
+
+        constexpr size_t batchSize = 64;
+        Task sumTask = manager.createTask("../examples/shaders/sum.spv");
+        Buffer smallIn = manager.createBuffer(sizeof(uint32_t));
+        Buffer smallOut = manager.createBuffer(sizeof(uint32_t));
+
+        // job creation, per job
+        benchmarks.run(allocatorName, "job/create", 0, [&]() {
+            auto start = Clock::now();
+            for (size_t i = 0; i < batchSize; ++i)
+                Job job = manager.createJob();
+            return Sample{ elapsedMicroseconds(start) / batchSize };
+        });
+
+        // descriptor sets allocated for every resource set, per set
+        benchmarks.run(allocatorName, "descriptor/resource_set", 0, [&]() {
+            std::vector<ResourceSet> sets;
+            sets.reserve(batchSize);
+            auto start = Clock::now();
+            for (size_t i = 0; i < batchSize; ++i)
+                sets.push_back(manager.createResourceSet(sumTask, 0, { &smallIn, &smallOut }));
+            return Sample{ elapsedMicroseconds(start) / batchSize };
+        });
+
+        // recording of the tasks that reuse cached descriptor sets, per task
+        {
+            Job job = manager.createJob();
+            benchmarks.run(allocatorName, "descriptor/cached_bind", 0, [&]() {
+                job.reset();
+                auto start = Clock::now();
+                for (size_t i = 0; i < batchSize; ++i)
+                    job.addTask(sumTask, { { &smallIn, &smallOut } }, 1);
+                return Sample{ elapsedMicroseconds(start) / batchSize };
+            });
+        }
+
+        // round trip of the smallest job
+        {
+            Job job = manager.createJob();
+            job.addTask(sumTask, { { &smallIn, &smallOut } }, 1);
+            benchmarks.run(allocatorName, "submit/latency", 0, [&]() {
+                return runJob(job);
+            });
+        }
+
+        // transfers between the host and all kinds of buffers
+        for (auto type : { Buffer::Type::DeviceLocal, Buffer::Type::Staging, Buffer::Type::Uniform, Buffer::Type::DeviceMapped })
+        {
+            for (size_t size : { 64 * 1024, 1024 * 1024, 16 * 1024 * 1024 })
+            {
+                std::string suffix = bufferTypeName(type) + "/" + sizeName(size);
+                Buffer buffer = manager.createBuffer(size, type);
+                std::vector<uint32_t> data = makeInput(size / sizeof(uint32_t), UINT32_MAX);
+
+                Job upload = manager.createJob();
+                upload.syncResourceToDevice(buffer, data.data(), size);
+                benchmarks.run(allocatorName, "transfer/upload/" + suffix, size, [&]() {
+                    return runJob(upload);
+                });
+
+                Job readback = manager.createJob();
+                readback.syncResourceToHost(buffer, data.data(), size);
+                benchmarks.run(allocatorName, "transfer/readback/" + suffix, size, [&]() {
+                    return runJob(readback);
+                });
+            }
+        }
+
+        // dispatches, GPU time includes only the tasks
+        constexpr uint32_t count = 1024 * 1024;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        {
+            Buffer in = manager.createBuffer(dataSize);
+            Buffer out = manager.createBuffer(dataSize);
+            std::vector<uint32_t> data = makeInput(count, 1024);
+            Job job = manager.createJob();
+            job.syncResourceToDevice(in, data.data(), dataSize)
+                .syncResourceToDevice(out, data.data(), dataSize)
+                .submit()
+                .await();
+
+            job.reset();
+            job.addTaskRange(sumTask, { { &in, &out } }, count);
+            benchmarks.run(allocatorName, "dispatch/sum/" + std::to_string(count), 2 * dataSize, [&]() {
+                return runJob(job, "task");
+            });
+        }
+        {
+            // input is uploaded every iteration, since the task overwrites it with larger values
+            Task task = manager.createTask("../examples/shaders/fibonacci.spv", count);
+            Buffer buffer = manager.createBuffer(dataSize);
+            std::vector<uint32_t> data = makeInput(count, 32);
+            Job job = manager.createJob();
+            job.syncResourceToDevice(buffer, data.data(), dataSize)
+                .addTaskRange(task, { { &buffer } }, count);
+            benchmarks.run(allocatorName, "dispatch/fibonacci/" + std::to_string(count), dataSize, [&]() {
+                return runJob(job, "task");
+            });
+        }
+        {
+            constexpr int localSize = 16;
+            utils::Image pixels(1024, 1024, 4);
+            std::mt19937 gen(42);
+            for (int i = 0; i < pixels.size; ++i)
+                pixels.data[i] = static_cast<unsigned char>(gen());
+
+            Task task = manager.createTask("../examples/shaders/edgedetect.spv", localSize, localSize);
+            Image imageIn = manager.createImage(pixels.width, pixels.height);
+            Image imageOut = manager.createImage(pixels.width, pixels.height);
+            Job job = manager.createJob();
+            job.syncResourceToDevice(imageIn, pixels.data, pixels.size)
+                .syncResourceToDevice(imageOut, 0, 0)
+                .submit()
+                .await();
+
+            job.reset();
+            job.addTaskRange(task, { { &imageIn, &imageOut } }, pixels.width, pixels.height);
+            std::string name = "dispatch/edgedetect/" + std::to_string(pixels.width) + "x" + std::to_string(pixels.height);
+            benchmarks.run(allocatorName, name, 2 * static_cast<size_t>(pixels.size), [&]() {
+                return runJob(job, "task");
+            });
+        }
+
+        auto properties = manager.getDeviceProperties();
+        std::cout << allocatorName << " allocator done on " << properties.deviceName << '\n';
+
+        return properties;
+    }
+
+    void writeString(std::ostream &os, const std::string &value)
+    {
+        os << '"';
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+                os << '\\';
+            if (static_cast<unsigned char>(c) >= 0x20)
+                os << c;
+        }
+        os << '"';
+    }
+
+    void writeStats(std::ostream &os, const std::string &key)
+    {
+        auto it = utils::measures.find(key);
+        if (it == utils::measures.end())
+        {
+            os << "null";
+            return;
+        }
+
+        auto stats = computeStats(it->second);
+        os << "{\"mean\":" << stats.average << ",\"trimmed\":" << stats.trimmed << ",\"median\":" << stats.median
+           << ",\"min\":" << stats.min << ",\"max\":" << stats.max << "}";
+    }
+
+    void writeJson(std::ostream &os, const std::vector<Case> &cases, const Options &options,
+        const VkPhysicalDeviceProperties &properties)
+    {
+        os << std::fixed << std::setprecision(3);
+        os << "{\n\"device\":";
+        writeString(os, properties.deviceName);
+        os << ",\n\"driverVersion\":" << properties.driverVersion
+           << ",\n\"apiVersion\":" << properties.apiVersion
+           << ",\n\"iterations\":" << options.iterations
+           << ",\n\"warmup\":" << options.warmup
+           << ",\n\"unit\":\"us\""
+           << ",\n\"benchmarks\":[";
+        for (size_t i = 0; i < cases.size(); ++i)
+        {
+            const auto &benchmark = cases[i];
+            std::string key = benchmark.allocator + "/" + benchmark.name;
+            os << (i > 0 ? "," : "") << "\n{\"name\":";
+            writeString(os, benchmark.name);
+            os << ",\"allocator\":";
+            writeString(os, benchmark.allocator);
+            os << ",\"bytes\":" << benchmark.bytes << ",\"host\":";
+            writeStats(os, key + "/host");
+            os << ",\"gpu\":";
+            writeStats(os, key + "/gpu");
+            if (benchmark.bytes > 0)
+            {
+                // bytes per microsecond are megabytes per second
+                float median = computeStats(utils::measures[key + "/host"]).median;
+                os << ",\"hostBandwidthMBps\":" << (median > 0 ? benchmark.bytes / median : 0.0f);
+            }
+            os << "}";
+        }
+        os << "\n]\n}\n";
+    }
+
+    Options parseOptions(int argc, char **argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (i + 1 >= argc)
+                throw std::runtime_error("Missing value of " + arg);
+
+            std::string value = argv[++i];
+            if (arg == "--iterations")
+                options.iterations = std::stoul(value);
+            else if (arg == "--warmup")
+                options.warmup = std::stoul(value);
+            else if (arg == "--allocator")
+                options.allocator = value;
+            else if (arg == "--filter")
+                options.filter = value;
+            else if (arg == "--json")
+                options.jsonPath = value;
+            else
+                throw std::runtime_error("Unknown option " + arg);
+        }
+        if (options.allocator != "simple" && options.allocator != "vma" && options.allocator != "all")
+            throw std::runtime_error("Unknown allocator " + options.allocator);
+
+        return options;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Options options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n'
+                  << "Usage: gpujob_bench [--iterations N] [--warmup N] [--allocator simple|vma|all] "
+                     "[--filter SUBSTRING] [--json PATH]\n";
+        return 1;
+    }
+
+    Benchmarks benchmarks(options);
+    VkPhysicalDeviceProperties properties{};
+    // allocators outlive the managers that use them
+    if (options.allocator != "vma")
+    {
+        SimpleDeviceMemoryAllocator allocator;
+        properties = runSuite(benchmarks, "simple", &allocator);
+    }
+    if (options.allocator != "simple")
+    {
+        VMADeviceMemoryAllocator allocator;
+        properties = runSuite(benchmarks, "vma", &allocator);
+    }
+
+    printMeasures(2, true);
+
+    std::ofstream ofs(options.jsonPath);
+    if (!ofs.is_open())
+    {
+        std::cerr << "Failed to open " << options.jsonPath << '\n';
+        return 1;
+    }
+    writeJson(ofs, benchmarks.getCases(), options, properties);
+    std::cout << "Results saved to " << options.jsonPath << '\n';
+}
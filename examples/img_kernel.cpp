@@ -33,7 +33,7 @@ int main()
     // record commands
     job.syncResourceToDevice(imageIn, pixels, imageSize)
         .syncResourceToDevice(imageOut, 0, 0)
-        .addTask(task, { {&imageIn, &imageOut} }, texWidth / localGroupSize, texHeight / localGroupSize)
+        .addTaskRange(task, { {&imageIn, &imageOut} }, texWidth, texHeight)
         .syncResourceToHost(imageOut, imgOut.get(), imageSize)
         .submit()
         .await();
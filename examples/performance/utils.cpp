@@ -12,6 +12,11 @@
 using namespace utils;
 
 void addMeasure(size_t key, float time)
+{
+    addMeasure(std::to_string(key), time);
+}
+
+void addMeasure(const std::string &key, float time)
 {
     if (auto it = utils::measures.find(key); it != utils::measures.end())
     {
@@ -23,6 +28,31 @@ void addMeasure(size_t key, float time)
     }
 }
 
+MeasureStats computeStats(std::vector<float> times, size_t trim)
+{
+    MeasureStats stats;
+    if (times.empty())
+    {
+        return stats;
+    }
+
+    std::sort(times.begin(), times.end());
+    auto total = std::accumulate(times.begin(), times.end(), 0.0f);
+    stats.average = total / times.size();
+    stats.trimmed = stats.average;
+    if (times.size() > trim * 2)
+    {
+        total = std::accumulate(times.begin() + trim, times.end() - trim, 0.0f);
+        stats.trimmed = total / (times.size() - trim * 2);
+    }
+    size_t middle = times.size() / 2;
+    stats.median = times.size() % 2 ? times[middle] : (times[middle - 1] + times[middle]) / 2;
+    stats.min = times.front();
+    stats.max = times.back();
+
+    return stats;
+}
+
 void printMeasures(size_t trim, bool onlyResults)
 {
     for (auto& [key, times] : utils::measures)
@@ -33,14 +63,12 @@ void printMeasures(size_t trim, bool onlyResults)
             printVector(times);
         }
 
-        auto total = std::accumulate(times.begin(), times.end(), (decltype (times)::value_type)(0));
-        std::cout << " | Average: " << float(total) / times.size();
+        auto stats = computeStats(times, trim);
+        std::cout << " | Average: " << stats.average;
 
         if (times.size() > trim * 2)
         {
-            std::sort(times.begin(), times.end());
-            total = std::accumulate(times.begin() + trim, times.end() - trim, (decltype (times)::value_type)(0));
-            std::cout << " | Trimmed: " << float(total) / (times.size() - trim * 2);
+            std::cout << " | Trimmed: " << stats.trimmed;
         }
 
         std::cout << '\n';
@@ -10,7 +10,18 @@
 
 namespace utils
 {
-    inline std::map<size_t, std::vector<float>> measures;
+    inline std::map<std::string, std::vector<float>> measures;
+
+    struct MeasureStats
+    {
+        float average = 0;
+        // average without the \p trim smallest and largest times, equal to the average if
+        // there are not enough times
+        float trimmed = 0;
+        float median = 0;
+        float min = 0;
+        float max = 0;
+    };
     
     class Image;
 }
@@ -28,6 +39,10 @@ void printVector(const std::vector<T> &vec)
 
 void addMeasure(size_t key, float time);
 
+void addMeasure(const std::string &key, float time);
+
+utils::MeasureStats computeStats(std::vector<float> times, size_t trim = 2);
+
 void printMeasures(size_t trim = 2, bool onlyResults = false);
 
 void clearMeasures();
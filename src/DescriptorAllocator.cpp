@@ -0,0 +1,109 @@
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+DescriptorAllocator::DescriptorAllocator(const std::vector<VkDescriptorType> &types, uint32_t setsPerPool,
+    bool freeSets) :
+    types(types),
+    setsPerPool(setsPerPool),
+    freeSets(freeSets)
+{}
+
+void DescriptorAllocator::initialize(VkDevice newDevice)
+{
+    device = newDevice;
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout)
+{
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet descriptorSet;
+    while (true)
+    {
+        bool newPool = currentPool == pools.size();
+        if (newPool)
+        {
+            pools.push_back(createPool());
+        }
+
+        allocInfo.descriptorPool = pools[currentPool];
+        VkResult res = vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
+        if (res == VK_SUCCESS)
+        {
+            if (freeSets)
+                setPools.emplace(descriptorSet, currentPool);
+            return descriptorSet;
+        }
+
+        // set does not fit even into the empty pool
+        if (newPool || (res != VK_ERROR_OUT_OF_POOL_MEMORY && res != VK_ERROR_FRAGMENTED_POOL))
+        {
+            throw std::runtime_error("failed to allocate descriptor sets!");
+        }
+
+        ++currentPool;
+    }
+}
+
+void DescriptorAllocator::free(VkDescriptorSet set)
+{
+    auto it = setPools.find(set);
+    if (it == setPools.end())
+    {
+        throw std::runtime_error("Descriptor set can not be freed by the allocator");
+    }
+
+    vkFreeDescriptorSets(device, pools[it->second], 1, &set);
+    // space of the set is reused by the following allocations
+    currentPool = std::min(currentPool, it->second);
+    setPools.erase(it);
+}
+
+size_t DescriptorAllocator::getPoolCount() const
+{
+    return pools.size();
+}
+
+void DescriptorAllocator::reset()
+{
+    for (auto pool : pools)
+        vkResetDescriptorPool(device, pool, 0);
+    setPools.clear();
+    currentPool = 0;
+}
+
+void DescriptorAllocator::destroy()
+{
+    for (auto pool : pools)
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    pools.clear();
+    setPools.clear();
+    currentPool = 0;
+}
+
+VkDescriptorPool DescriptorAllocator::createPool()
+{
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (auto type : types)
+        poolSizes.push_back({ type, setsPerPool * descriptorsPerSet });
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = freeSets ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = setsPerPool;
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    return pool;
+}
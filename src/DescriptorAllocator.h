@@ -0,0 +1,90 @@
+#ifndef DESCRIPTOR_ALLOCATOR_H
+#define DESCRIPTOR_ALLOCATOR_H
+
+#include <vulkan/vulkan.h>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Allocator of descriptor sets that grows by creating new descriptor pools.
+ * 
+ * All sets allocated from the allocator are freed at once by reset(), which keeps
+ * already created pools for the following allocations. Allocators created with
+ * \p freeSets can also free single sets, whose space is reused before new pools are
+ * created.
+ */
+class DescriptorAllocator
+{
+    VkDevice device = VK_NULL_HANDLE;
+    std::vector<VkDescriptorType> types;
+    uint32_t setsPerPool;
+    bool freeSets;
+
+    std::vector<VkDescriptorPool> pools;
+    // pool indices of the allocated sets, tracked only if sets can be freed
+    std::unordered_map<VkDescriptorSet, size_t> setPools;
+    // index of the pool used for the next allocation
+    size_t currentPool = 0;
+
+public:
+    /**
+     * @brief Construct a new Descriptor Allocator object
+     * 
+     * @param types Descriptor types that can be allocated from the pools
+     * @param setsPerPool Maximum number of sets in a single pool. Each pool also holds
+     * descriptorsPerSet descriptors of every type for each set
+     * @param freeSets Create pools that allow to free single sets, see free()
+     */
+    DescriptorAllocator(const std::vector<VkDescriptorType> &types = {}, uint32_t setsPerPool = 256,
+        bool freeSets = false);
+
+    /**
+     * @brief Set the device used to create pools. Should be called before any allocation.
+     */
+    void initialize(VkDevice device);
+
+    /**
+     * @brief Allocate descriptor set, creating new pool if needed.
+     * 
+     * @param layout Layout of the descriptor set
+     * @return Allocated descriptor set
+     */
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+
+    /**
+     * @brief Free single descriptor set, only allowed if the allocator was created with
+     * freeSets.
+     * 
+     * Set must not be used by any pending or recorded command buffer.
+     * 
+     * @param set Set allocated from this allocator
+     */
+    void free(VkDescriptorSet set);
+
+    /**
+     * @brief Get number of the created pools.
+     */
+    size_t getPoolCount() const;
+
+    /**
+     * @brief Free all allocated descriptor sets.
+     * 
+     * Sets must not be used by any pending or recorded command buffer.
+     */
+    void reset();
+
+    /**
+     * @brief Destroy all pools.
+     */
+    void destroy();
+
+    /**
+     * @brief Average number of descriptors of each type reserved per set.
+     */
+    static constexpr uint32_t descriptorsPerSet = 4;
+
+private:
+    VkDescriptorPool createPool();
+};
+
+#endif // DESCRIPTOR_ALLOCATOR_H
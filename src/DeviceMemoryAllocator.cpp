@@ -1,4 +1,5 @@
 #include "DeviceMemoryAllocator.h"
+#include "JobManager.h"
 
 #define VMA_IMPLEMENTATION
 #define VMA_VULKAN_VERSION 1001000
@@ -11,6 +12,10 @@ VkResult SimpleDeviceMemoryAllocator::initialize(JobManager* manager, VkPhysical
     this->device = device;
     this->physicalDevice = physicalDevice;
 
+    // memory properties do not change, so they are queried once instead of on every allocation
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    allocatedBytes.assign(memoryProperties.memoryHeapCount, 0);
+
     return VK_SUCCESS;
 }
 
@@ -33,12 +38,22 @@ AllocatedMemory SimpleDeviceMemoryAllocator::createBuffer(VkBuffer& buffer, cons
     allocInfo.allocationSize = memRequirements.size;
     allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties, optionalProperties);
 
+    VkMemoryAllocateFlagsInfo allocFlagsInfo{};
+    allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+    if (createInfo.usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
+        allocInfo.pNext = &allocFlagsInfo;
+
     AllocatedMemory allocatedMemory{};
     if (vkAllocateMemory(device, &allocInfo, nullptr, &allocatedMemory.memory) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to allocate buffer memory!");
     }
 
+    uint32_t heapIndex = memoryProperties.memoryTypes[allocInfo.memoryTypeIndex].heapIndex;
+    allocations[allocatedMemory.memory] = { heapIndex, allocInfo.allocationSize };
+    allocatedBytes[heapIndex] += allocInfo.allocationSize;
+
     vkBindBufferMemory(device, buffer, allocatedMemory.memory, 0);
 
     return allocatedMemory;
@@ -65,6 +80,10 @@ AllocatedMemory SimpleDeviceMemoryAllocator::createImage(VkImage& image, const V
         throw std::runtime_error("failed to allocate image memory!");
     }
 
+    uint32_t heapIndex = memoryProperties.memoryTypes[allocInfo.memoryTypeIndex].heapIndex;
+    allocations[allocatedMemory.memory] = { heapIndex, allocInfo.allocationSize };
+    allocatedBytes[heapIndex] += allocInfo.allocationSize;
+
     vkBindImageMemory(device, image, allocatedMemory.memory, 0);
 
     return allocatedMemory;
@@ -72,6 +91,13 @@ AllocatedMemory SimpleDeviceMemoryAllocator::createImage(VkImage& image, const V
 
 void SimpleDeviceMemoryAllocator::freeMemory(const AllocatedMemory& allocatedMemory)
 {
+    auto it = allocations.find(allocatedMemory.memory);
+    if (it != allocations.end())
+    {
+        allocatedBytes[it->second.first] -= it->second.second;
+        allocations.erase(it);
+    }
+
     vkFreeMemory(device, allocatedMemory.memory, nullptr);
 }
 
@@ -85,10 +111,42 @@ void SimpleDeviceMemoryAllocator::unmapMemory(const AllocatedMemory& allocatedMe
     vkUnmapMemory(device, allocatedMemory.memory);
 }
 
+bool SimpleDeviceMemoryAllocator::supportsBufferDeviceAddress() const
+{
+    return true;
+}
+
+std::vector<MemoryHeapStatistics> SimpleDeviceMemoryAllocator::getHeapStatistics()
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    bool hasBudget = manager->supportsMemoryBudget();
+    if (hasBudget)
+    {
+        VkPhysicalDeviceMemoryProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties2.pNext = &budgetProperties;
+        vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &properties2);
+    }
+
+    std::vector<MemoryHeapStatistics> statistics(memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++)
+    {
+        statistics[i].size = memoryProperties.memoryHeaps[i].size;
+        statistics[i].flags = memoryProperties.memoryHeaps[i].flags;
+        // every allocation holds exactly one resource
+        statistics[i].allocatedBytes = allocatedBytes[i];
+        statistics[i].usedBytes = allocatedBytes[i];
+        statistics[i].usage = hasBudget ? budgetProperties.heapUsage[i] : allocatedBytes[i];
+        statistics[i].budget = hasBudget ? budgetProperties.heapBudget[i] : memoryProperties.memoryHeaps[i].size * 8 / 10;
+    }
+
+    return statistics;
+}
+
 uint32_t SimpleDeviceMemoryAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags optionalProperties)
 {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    const VkPhysicalDeviceMemoryProperties &memProperties = memoryProperties;
 
     optionalProperties |= properties;
     for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
@@ -119,6 +177,12 @@ VkResult VMADeviceMemoryAllocator::initialize(JobManager* manager, VkPhysicalDev
     allocatorCreateInfo.physicalDevice = physicalDevice;
     allocatorCreateInfo.device = device;
     allocatorCreateInfo.instance = instance;
+    if (manager->supportsMemoryBudget())
+        allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    memoryHeaps.assign(memoryProperties.memoryHeaps, memoryProperties.memoryHeaps + memoryProperties.memoryHeapCount);
 
     return vmaCreateAllocator(&allocatorCreateInfo, &allocator);
 }
@@ -183,6 +247,33 @@ void VMADeviceMemoryAllocator::unmapMemory(const AllocatedMemory& allocatedMemor
     vmaUnmapMemory(allocator, customData->allocation);
 }
 
+std::vector<MemoryHeapStatistics> VMADeviceMemoryAllocator::getHeapStatistics()
+{
+    // vmaGetBudget() falls back to its own estimate when VK_EXT_memory_budget is not enabled
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetBudget(allocator, budgets);
+
+    std::vector<MemoryHeapStatistics> statistics(memoryHeaps.size());
+    for (size_t i = 0; i < memoryHeaps.size(); i++)
+    {
+        statistics[i].size = memoryHeaps[i].size;
+        statistics[i].flags = memoryHeaps[i].flags;
+        statistics[i].allocatedBytes = budgets[i].blockBytes;
+        statistics[i].usedBytes = budgets[i].allocationBytes;
+        statistics[i].usage = budgets[i].usage;
+        statistics[i].budget = budgets[i].budget;
+    }
+
+    return statistics;
+}
+
+VmaStats VMADeviceMemoryAllocator::calculateStatistics()
+{
+    VmaStats stats;
+    vmaCalculateStats(allocator, &stats);
+    return stats;
+}
+
 VMACustomData* VMADeviceMemoryAllocator::getCustomData(const AllocatedMemory& allocatedMemory)
 {
     return static_cast<VMACustomData*>(allocatedMemory.customData);;
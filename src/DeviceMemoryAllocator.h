@@ -6,6 +6,9 @@
 #include <vulkan/vulkan.h>
 #include <vk_mem_alloc.h>
 
+#include <unordered_map>
+#include <vector>
+
 class JobManager;
 
 /**
@@ -95,6 +98,23 @@ public:
      * @param allocatedMemory Host-visible memory allocated with this allocator that was previously mapped.
      */
     virtual void unmapMemory(const AllocatedMemory& allocatedMemory) = 0;
+
+    /**
+     * @brief Get memory usage and budget of every memory heap of the device.
+     * 
+     * Should be cheap enough to be called before every allocation. Default implementation
+     * returns no statistics, which disables JobManagerSettings::memorySoftLimit.
+     * 
+     * @return std::vector<MemoryHeapStatistics> Statistics indexed by memory heap index
+     */
+    virtual std::vector<MemoryHeapStatistics> getHeapStatistics() { return {}; }
+
+    /**
+     * @brief Check whether the allocator can allocate memory for the buffers with
+     * VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT (see JobManagerSettings::enableBufferDeviceAddress).
+     * Default implementation returns false, which disables buffer device addresses.
+     */
+    virtual bool supportsBufferDeviceAddress() const { return false; }
 };
 
 /**
@@ -107,6 +127,10 @@ class SimpleDeviceMemoryAllocator : public DeviceMemoryAllocator
     JobManager* manager;
     VkDevice device;
     VkPhysicalDevice physicalDevice;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    // heap index and size of every allocation, needed to update usage when it is freed
+    std::unordered_map<VkDeviceMemory, std::pair<uint32_t, VkDeviceSize>> allocations;
+    std::vector<VkDeviceSize> allocatedBytes;
 
 public:
     virtual VkResult initialize(JobManager*, VkPhysicalDevice, VkDevice, VkInstance) override;
@@ -120,6 +144,10 @@ public:
     virtual VkResult mapMemory(const AllocatedMemory& allocatedMemory, VkDeviceSize size, void** ppData) override;
     virtual void unmapMemory(const AllocatedMemory& allocatedMemory) override;
 
+    virtual std::vector<MemoryHeapStatistics> getHeapStatistics() override;
+
+    virtual bool supportsBufferDeviceAddress() const override;
+
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags optionalProperties = 0);
 };
 
@@ -153,7 +181,20 @@ public:
     virtual VkResult mapMemory(const AllocatedMemory& allocatedMemory, VkDeviceSize size, void** ppData) override;
     virtual void unmapMemory(const AllocatedMemory& allocatedMemory) override;
 
+    virtual std::vector<MemoryHeapStatistics> getHeapStatistics() override;
+
+    /**
+     * @brief Calculate detailed statistics (number of blocks and allocations, sizes of
+     * allocations and unused ranges) per memory type and heap.
+     * 
+     * Traverses all allocations, so it is meant for debugging and profiling rather than
+     * for being called on every allocation.
+     */
+    VmaStats calculateStatistics();
+
 private:
+    std::vector<VkMemoryHeap> memoryHeaps;
+
     static VMACustomData* getCustomData(const AllocatedMemory& allocatedMemory);
 };
 
@@ -7,21 +7,112 @@ Job::Job(JobManager *manager, VkCommandBuffer commandBuffer, VkQueue computeQueu
     computeQueue(computeQueue),
     commandBuffer(commandBuffer),
     fence(fence),
-    signalSemaphore(VK_NULL_HANDLE)
+    signalSemaphore(VK_NULL_HANDLE),
+    resourceGeneration(manager->resourceGeneration)
 {
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    // beginInfo.flags;
-
     if (computeQueue != VK_NULL_HANDLE && fence != VK_NULL_HANDLE)
     {
-        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        beginCommandBuffer(commandBuffer);
+
+        if (manager->hasDedicatedTransferQueue())
         {
-            throw std::runtime_error("Failed to begin recording command buffer!");
+            transferQueue = manager->transferQueue;
         }
     }
 }
 
+Job::~Job()
+{
+    // only jobs created by JobManager own their objects
+    if (!recycleGuard.active || commandPool.pool == VK_NULL_HANDLE || resourceGeneration != manager->resourceGeneration)
+        return;
+
+    // secondary job that was never executed is not used by the device
+    if (isSecondary)
+    {
+        manager->releaseCommandPools({ std::move(commandPool) });
+        return;
+    }
+
+    JobManager::RecycledJobObjects objects{ fence };
+    objects.commandPools = std::move(executedCommandPools);
+    objects.commandPools.push_back(std::move(commandPool));
+    if (transferCommandPool.pool != VK_NULL_HANDLE)
+        objects.transferCommandPools.push_back(std::move(transferCommandPool));
+    // signal semaphore is not reused since it might have been never waited
+    for (auto semaphore : { uploadSemaphore, computeSemaphore })
+    {
+        if (semaphore != VK_NULL_HANDLE)
+            objects.semaphores.push_back(semaphore);
+    }
+    if (timelineSemaphore != VK_NULL_HANDLE)
+        objects.timelineSemaphores.push_back(timelineSemaphore);
+    objects.queryPools = queryPools;
+    objects.statisticsQueryPools = statisticsQueryPools;
+    objects.batchFence = batchFence;
+    objects.resources = std::move(usedResources);
+    for (const auto &block : transientBlocks)
+        objects.resources.insert(block.buffer.getLifetime());
+
+    manager->recycleJobObjects(std::move(objects));
+}
+
+Job& Job::reset()
+{
+    if (isSubmitted)
+    {
+        throw std::runtime_error("Tried to reset job without awaiting for its completion");
+    }
+
+    if (commandPool.pool != VK_NULL_HANDLE)
+    {
+        // pool hands out the same command buffer again
+        manager->resetCommandPool(commandPool);
+        commandBuffer = manager->allocateCommandBuffer(commandPool,
+            isSecondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        beginCommandBuffer(commandBuffer, isSecondary);
+
+        // transfer command buffers are started again on the first use
+        if (transferCommandPool.pool != VK_NULL_HANDLE)
+            manager->resetCommandPool(transferCommandPool);
+        uploadCommandBuffer = VK_NULL_HANDLE;
+        readbackCommandBuffer = VK_NULL_HANDLE;
+
+        manager->releaseCommandPools(std::move(executedCommandPools));
+        executedCommandPools.clear();
+    }
+    else if (isSecondary)
+    {
+        throw std::runtime_error("Tried to reset secondary job that was executed by another job");
+    }
+
+    isRecorded = false;
+    hasComputeCommands = false;
+    pendingBindings.clear();
+    pendingAddressedBuffers.clear();
+    pendingConstants.reset();
+    preExecutionTransfers.clear();
+    postExecutionTransfers.clear();
+    unguardedResourceAccess.clear();
+    offloadedUploads.clear();
+    offloadedReadbacks.clear();
+    stagingRegions.clear();
+    dependencies.clear();
+    batchFence.reset();
+    usedResources.clear();
+    for (auto &block : transientBlocks)
+        block.freeRanges = { { 0, block.buffer.getSize(), false } };
+    pendingBufferBarriers.clear();
+    pendingImageBarriers.clear();
+    profiledScopes.clear();
+    profilingResults.clear();
+    timestampQueryCount = 0;
+    statisticsQueryCount = 0;
+    taskCount = 0;
+
+    return *this;
+}
+
 void Job::setAutoDataDependencyManagement(bool value)
 {
     autoDataDependencyManagement = value;
@@ -29,16 +120,86 @@ void Job::setAutoDataDependencyManagement(bool value)
 
 Job& Job::addTask(const Task &task, uint32_t groupX, uint32_t groupY, uint32_t groupZ)
 {
+    hasComputeCommands = true;
     checkDataDependencyInPendingBindings(task);
 
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, task.getPipeline());
-    bindPendingResources(task);
-
+    auto scope = prepareDispatch(task);
     vkCmdDispatch(commandBuffer, groupX, groupY, groupZ);
+    endProfiledScope(scope);
+
+    return *this;
+}
+
+Job& Job::addTaskRange(const Task &task, uint32_t globalX, uint32_t globalY, uint32_t globalZ)
+{
+    hasComputeCommands = true;
+    checkDataDependencyInPendingBindings(task);
+
+    const auto &localSize = task.getLocalSize();
+    uint32_t global[3] = { globalX, globalY, globalZ };
+    std::array<uint32_t, 3> groups;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        groups[i] = static_cast<uint32_t>((static_cast<uint64_t>(global[i]) + localSize[i] - 1) / localSize[i]);
+    }
+
+    const auto &limits = manager->computeLimits.maxComputeWorkGroupCount;
+    std::array<uint32_t, 3> maxGroups = { limits[0], limits[1], limits[2] };
+    auto scope = prepareDispatch(task);
+    splitDispatch(groups, maxGroups,
+        [this](const std::array<uint32_t, 3> &base, const std::array<uint32_t, 3> &count) {
+            if (base[0] == 0 && base[1] == 0 && base[2] == 0)
+                vkCmdDispatch(commandBuffer, count[0], count[1], count[2]);
+            else
+                vkCmdDispatchBase(commandBuffer, base[0], base[1], base[2], count[0], count[1], count[2]);
+        });
+    endProfiledScope(scope);
+
+    return *this;
+}
+
+Job& Job::addTaskRange(const Task &task, const std::vector<std::vector<Resource *>> &resources,
+    uint32_t globalX, uint32_t globalY, uint32_t globalZ)
+{
+    for (size_t i = 0; i < resources.size(); ++i)
+    {
+        useResources(i, resources.at(i));
+    }
+
+    return addTaskRange(task, globalX, globalY, globalZ);
+}
+
+Job& Job::addTaskIndirect(const Task &task, Buffer &args, size_t offset)
+{
+    if (args.getBufferType() != Buffer::Type::DeviceLocal && args.getBufferType() != Buffer::Type::DeviceMapped)
+        throw std::runtime_error("Indirect dispatch arguments must be stored in a storage buffer");
+    if (offset % 4 != 0 || offset + sizeof(VkDispatchIndirectCommand) > args.getSize())
+        throw std::runtime_error("Invalid offset of the indirect dispatch arguments");
+
+    retainResource(args);
+
+    hasComputeCommands = true;
+    checkDataDependencyInPendingBindings(task);
+    checkDataDependency({ &args }, Operation::Indirect, AccessType::Read, sizeof(VkDispatchIndirectCommand), offset);
+
+    auto scope = prepareDispatch(task);
+    vkCmdDispatchIndirect(commandBuffer, args.getBuffer(), args.getOffset() + offset);
+    endProfiledScope(scope);
 
     return *this;
 }
 
+std::optional<size_t> Job::prepareDispatch(const Task &task)
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, task.getPipeline());
+    bindPendingResources(task);
+
+    std::string name = task.getName().empty() ? "Task " + std::to_string(taskCount) : task.getName();
+    ++taskCount;
+    flushBarriers();
+    return beginProfiledScope(std::move(name), "task", true);
+}
+
 Job& Job::addTask(const Task &task, const std::vector<std::vector<Resource *>> &resources,
     uint32_t groupX, uint32_t groupY, uint32_t groupZ)
 {
@@ -75,76 +236,136 @@ Job& Job::useResources(size_t index, const std::vector<Resource *> &resources)
     return *this;
 }
 
-Job& Job::syncResourceToDevice(Resource &resource, const void *data, size_t size)
+Job& Job::useBufferAddresses(const std::vector<Buffer *> &buffers, AccessTypeFlags accessType)
+{
+    for (auto buffer : buffers)
+    {
+        if (buffer->getDeviceAddress() == 0)
+            throw std::runtime_error("Buffer does not have a device address");
+        pendingAddressedBuffers.emplace_back(buffer, accessType);
+    }
+
+    return *this;
+}
+
+Job& Job::syncResourceToDevice(Resource &resource, const void *data, size_t size, size_t offset)
 {
-    if (resource.getResourceType() == ResourceType::StorageBuffer)
+    size = getTransferSize(resource, size, offset);
+    retainResource(resource);
+
+    if (isBufferResource(resource.getResourceType()))
     {
         const Buffer &buffer = static_cast<const Buffer&>(resource);
-        size = std::min(size, buffer.getSize());
         switch(buffer.getBufferType())
         {
         case Buffer::Type::DeviceLocal:
         {
-            preExecutionTransfers.push_back({ buffer.getStagingBuffer(), size, data, false });
+            auto [staging, stagingOffset] = getStagingMemory(buffer.getStagingBuffer(), size, buffer.getOffset() + offset);
+            preExecutionTransfers.push_back({ staging, size, data, false, stagingOffset, &resource });
 
-            checkDataDependency({ &resource }, Operation::Transfer, AccessType::Write);
             VkBufferCopy copyRegion{};
+            copyRegion.srcOffset = stagingOffset;
+            copyRegion.dstOffset = buffer.getOffset() + offset;
             copyRegion.size = size;
-            vkCmdCopyBuffer(commandBuffer, buffer.getStagingBuffer()->getBuffer(), buffer.getBuffer(), 1, &copyRegion);
+            if (transferQueue != VK_NULL_HANDLE && !hasComputeCommands && offloadedReadbacks.count(&resource) == 0)
+            {
+                VkCommandBuffer uploadBuffer = getTransferCommandBuffer(uploadCommandBuffer);
+                // consecutive uploads into the same buffer
+                if (!offloadedUploads.insert(&resource).second)
+                {
+                    VkMemoryBarrier barrier{};
+                    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                    vkCmdPipelineBarrier(uploadBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                        0, 1, &barrier, 0, nullptr, 0, nullptr);
+                }
+                vkCmdCopyBuffer(uploadBuffer, staging->getBuffer(), buffer.getBuffer(), 1, &copyRegion);
+            }
+            else
+            {
+                checkDataDependency({ &resource }, Operation::Transfer, AccessType::Write, size, offset);
+                flushBarriers();
+                auto scope = beginProfiledScope("syncResourceToDevice", "transfer");
+                vkCmdCopyBuffer(commandBuffer, staging->getBuffer(), buffer.getBuffer(), 1, &copyRegion);
+                endProfiledScope(scope);
+            }
             break;
         }
         case Buffer::Type::Staging:
         case Buffer::Type::Uniform:
-            preExecutionTransfers.push_back({ &buffer, size, data, false });
+        case Buffer::Type::DeviceMapped:
+            preExecutionTransfers.push_back({ &buffer, size, data, false, buffer.getOffset() + offset, &resource });
             break;
         }
     }
-    else if (resource.getResourceType() == ResourceType::StorageImage)
+    else if (isImageResource(resource.getResourceType()))
     {
         Image &image = static_cast<Image&>(resource);
         VkDeviceSize imageSize = image.getSize();
 
         if (data == nullptr)
         {
-            transitionImageLayout(image, VK_IMAGE_LAYOUT_GENERAL);
+            queueImageLayoutTransition(image, VK_IMAGE_LAYOUT_GENERAL);
             return *this;
         }
 
         if (size != imageSize)
             throw std::runtime_error("The size of the passed data does not match the size of the image");
 
-        preExecutionTransfers.push_back({ image.getStagingBuffer(), size, data, false });
+        auto [staging, stagingOffset] = getStagingMemory(image.getStagingBuffer(), size);
+        preExecutionTransfers.push_back({ staging, size, data, false, stagingOffset, &resource });
 
-        transitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        manager->copyBufferToImage(commandBuffer, image.getStagingBuffer()->getBuffer(), image.getImage(), image.getWidth(), image.getHeight());
-        transitionImageLayout(image, VK_IMAGE_LAYOUT_GENERAL);
+        auto scope = beginProfiledScope("syncResourceToDevice", "transfer");
+        queueImageLayoutTransition(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        flushBarriers();
+        manager->copyBufferToImage(commandBuffer, staging->getBuffer(), image, stagingOffset);
+        queueImageLayoutTransition(image, VK_IMAGE_LAYOUT_GENERAL);
+        endProfiledScope(scope);
     }
 
     return *this;
 }
 
-Job& Job::syncResourceToHost(Resource &resource, void *data, size_t size)
+Job& Job::syncResourceToHost(Resource &resource, void *data, size_t size, size_t offset)
 {
-    if (resource.getResourceType() == ResourceType::StorageBuffer)
+    size_t transferSize = getTransferSize(resource, size, offset);
+    retainResource(resource);
+
+    if (isBufferResource(resource.getResourceType()))
     {
         const Buffer &buffer = static_cast<const Buffer&>(resource);
+        size = transferSize;
         if (buffer.getBufferType() == Buffer::Type::DeviceLocal)
         {
-            checkDataDependency({ &resource }, Operation::Transfer, AccessType::Read);
-            
             VkBufferCopy copyRegion{};
-            size = std::min(size, buffer.getSize());
+            auto [staging, stagingOffset] = getStagingMemory(buffer.getStagingBuffer(), size, buffer.getOffset() + offset, true);
+            copyRegion.srcOffset = buffer.getOffset() + offset;
+            copyRegion.dstOffset = stagingOffset;
             copyRegion.size = size;
-            vkCmdCopyBuffer(commandBuffer, buffer.getBuffer(), buffer.getStagingBuffer()->getBuffer(), 1, &copyRegion);
+            if (transferQueue != VK_NULL_HANDLE)
+            {
+                offloadedReadbacks.insert(&resource);
+                vkCmdCopyBuffer(getTransferCommandBuffer(readbackCommandBuffer),
+                    buffer.getBuffer(), staging->getBuffer(), 1, &copyRegion);
+            }
+            else
+            {
+                checkDataDependency({ &resource }, Operation::Transfer, AccessType::Read, size, offset);
+                flushBarriers();
+                auto scope = beginProfiledScope("syncResourceToHost", "transfer");
+                vkCmdCopyBuffer(commandBuffer, buffer.getBuffer(), staging->getBuffer(), 1, &copyRegion);
+                endProfiledScope(scope);
+            }
             
-            postExecutionTransfers.push_back({ buffer.getStagingBuffer(), size, data });
+            postExecutionTransfers.push_back({ staging, size, data, false, stagingOffset, &resource });
         }
         else
         {
-            postExecutionTransfers.push_back({ &buffer, size, data });
+            postExecutionTransfers.push_back({ &buffer, size, data, false, buffer.getOffset() + offset, &resource });
         }
     }
-    else if (resource.getResourceType() == ResourceType::StorageImage)
+    else if (isImageResource(resource.getResourceType()))
     {
         Image &image = static_cast<Image&>(resource);
         VkDeviceSize imageSize = image.getSize();
@@ -152,39 +373,55 @@ Job& Job::syncResourceToHost(Resource &resource, void *data, size_t size)
         if (size < imageSize)
             throw std::runtime_error("The size of the passed data is smaller than the size of the image");
 
-        transitionImageLayout(image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-        manager->copyImageToBuffer(commandBuffer, image.getStagingBuffer()->getBuffer(), image.getImage(), image.getWidth(), image.getHeight());
-        transitionImageLayout(image, VK_IMAGE_LAYOUT_GENERAL);
+        auto [staging, stagingOffset] = getStagingMemory(image.getStagingBuffer(), imageSize, 0, true);
+
+        auto scope = beginProfiledScope("syncResourceToHost", "transfer");
+        queueImageLayoutTransition(image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        flushBarriers();
+        manager->copyImageToBuffer(commandBuffer, staging->getBuffer(), image, stagingOffset);
+        queueImageLayoutTransition(image, VK_IMAGE_LAYOUT_GENERAL);
+        endProfiledScope(scope);
 
-        postExecutionTransfers.push_back({ image.getStagingBuffer(), imageSize, data });
+        postExecutionTransfers.push_back({ staging, imageSize, data, false, stagingOffset, &resource });
     }
 
     return *this;
 }
 
-Job& Job::syncResources(Resource &src, Resource &dst)
+Job& Job::syncResources(Resource &src, Resource &dst, size_t size, size_t srcOffset, size_t dstOffset)
 {
-    if (src.getResourceType() == ResourceType::StorageImage && dst.getResourceType() == ResourceType::StorageImage)
+    size = std::min(getTransferSize(src, size, srcOffset), getTransferSize(dst, size, dstOffset));
+    retainResource(src);
+    retainResource(dst);
+
+    if (isImageResource(src.getResourceType()) && isImageResource(dst.getResourceType()))
     {
         Image &srcImg = static_cast<Image&>(src);
         Image &dstImg = static_cast<Image&>(dst);
 
-        transitionImageLayout(srcImg, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-        transitionImageLayout(dstImg, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        manager->copyImageToImage(commandBuffer, srcImg.getImage(), srcImg.getLayout(), dstImg.getImage(), dstImg.getLayout(), 
-            std::min(srcImg.getWidth(), dstImg.getWidth()), std::min(srcImg.getHeight(), dstImg.getHeight()));
-        transitionImageLayout(srcImg, VK_IMAGE_LAYOUT_GENERAL);
-        transitionImageLayout(dstImg, VK_IMAGE_LAYOUT_GENERAL);
+        auto scope = beginProfiledScope("syncResources", "transfer");
+        queueImageLayoutTransition(srcImg, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        queueImageLayoutTransition(dstImg, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        flushBarriers();
+        manager->copyImageToImage(commandBuffer, srcImg, dstImg);
+        queueImageLayoutTransition(srcImg, VK_IMAGE_LAYOUT_GENERAL);
+        queueImageLayoutTransition(dstImg, VK_IMAGE_LAYOUT_GENERAL);
+        endProfiledScope(scope);
     }
-    else if (src.getResourceType() == ResourceType::StorageBuffer && dst.getResourceType() == ResourceType::StorageBuffer)
+    else if (isBufferResource(src.getResourceType()) && isBufferResource(dst.getResourceType()))
     {
         Buffer &srcBuffer = static_cast<Buffer&>(src);
         Buffer &dstBuffer = static_cast<Buffer&>(dst);
 
-        checkDataDependency({ &src, &dst }, Operation::Transfer, { AccessType::Read, AccessType::Write });
+        // ranges are tracked separately for both buffers
+        checkDataDependency({ &src }, Operation::Transfer, AccessType::Read, size, srcOffset);
+        checkDataDependency({ &dst }, Operation::Transfer, AccessType::Write, size, dstOffset);
+        flushBarriers();
 
+        auto scope = beginProfiledScope("syncResources", "transfer");
         manager->copyBufferToBuffer(commandBuffer, srcBuffer.getBuffer(), dstBuffer.getBuffer(),
-            std::min(srcBuffer.getSize(), dstBuffer.getSize()));
+            size, srcBuffer.getOffset() + srcOffset, dstBuffer.getOffset() + dstOffset);
+        endProfiledScope(scope);
     }
     // TODO buffer to image, image to buffer
     else
@@ -195,6 +432,87 @@ Job& Job::syncResources(Resource &src, Resource &dst)
     return *this;
 }
 
+Buffer Job::createTransientBuffer(size_t size)
+{
+    size_t alignedSize = getTransientSize(size);
+
+    auto fits = [alignedSize](const TransientRange &range) { return range.size >= alignedSize; };
+    auto block = transientBlocks.begin();
+    std::vector<TransientRange>::iterator range;
+    for (; block != transientBlocks.end(); ++block)
+    {
+        range = std::find_if(block->freeRanges.begin(), block->freeRanges.end(), fits);
+        if (range != block->freeRanges.end())
+            break;
+    }
+
+    if (block == transientBlocks.end())
+    {
+        size_t blockSize = std::max(alignedSize, manager->settings.transientBlockSize);
+        Buffer blockBuffer = manager->allocateBuffer(blockSize, Buffer::Type::DeviceLocal, false);
+        transientBlocks.push_back({ blockBuffer, { { 0, blockSize, false } } });
+        block = transientBlocks.end() - 1;
+        range = block->freeRanges.begin();
+    }
+
+    if (range->aliased)
+    {
+        // previous users of the memory have to be done with it
+        addMemoryBarrier(
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+    }
+
+    const Buffer &blockBuffer = block->buffer;
+    Buffer buffer(blockBuffer.getBuffer(), blockBuffer.GetAllocatedMemory(), size, Buffer::Type::DeviceLocal, nullptr,
+        blockBuffer.getLifetime(), range->offset,
+        blockBuffer.getDeviceAddress() ? blockBuffer.getDeviceAddress() + range->offset : 0);
+
+    range->offset += alignedSize;
+    range->size -= alignedSize;
+    if (range->size == 0)
+        block->freeRanges.erase(range);
+
+    return buffer;
+}
+
+Job& Job::releaseTransientBuffer(const Buffer &buffer)
+{
+    auto block = std::find_if(transientBlocks.begin(), transientBlocks.end(), [&buffer](const TransientBlock &block) {
+        return block.buffer.getBuffer() == buffer.getBuffer();
+    });
+    if (block == transientBlocks.end())
+    {
+        throw std::runtime_error("Buffer was not created with createTransientBuffer() of this job");
+    }
+
+    auto &ranges = block->freeRanges;
+    TransientRange released{ buffer.getOffset(), getTransientSize(buffer.getSize()), true };
+    auto next = std::find_if(ranges.begin(), ranges.end(), [&released](const TransientRange &range) {
+        return range.offset > released.offset;
+    });
+
+    // merge with adjacent free ranges
+    if (next != ranges.end() && released.offset + released.size == next->offset)
+    {
+        released.size += next->size;
+        next = ranges.erase(next);
+    }
+    if (next != ranges.begin() && std::prev(next)->offset + std::prev(next)->size == released.offset)
+    {
+        std::prev(next)->size += released.size;
+        std::prev(next)->aliased = true;
+    }
+    else
+    {
+        ranges.insert(next, released);
+    }
+
+    return *this;
+}
+
 Job& Job::pushConstants(const void *data, size_t size)
 {
     std::shared_ptr<void> dst{ new char[size] };
@@ -241,11 +559,15 @@ Job& Job::waitBeforeTransfers()
 Job& Job::addMemoryBarrier(VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask,
     VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask)
 {
+    hasComputeCommands = true;
+    flushBarriers();
+
     VkMemoryBarrier barrier{};
     barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
     barrier.srcAccessMask = srcAccessMask;
     barrier.dstAccessMask = dstAccessMask;
 
+    beginDebugLabel("Memory barrier");
     vkCmdPipelineBarrier(
         commandBuffer,
         srcStageMask,
@@ -254,12 +576,17 @@ Job& Job::addMemoryBarrier(VkPipelineStageFlags srcStageMask, VkAccessFlags srcA
         1, &barrier,
         0, nullptr,
         0, nullptr);
+    endDebugLabel();
     
     return *this;
 }
 
 Job& Job::addExecutionBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask)
 {
+    hasComputeCommands = true;
+    flushBarriers();
+
+    beginDebugLabel("Execution barrier");
     vkCmdPipelineBarrier(
         commandBuffer,
         srcStageMask,
@@ -268,18 +595,116 @@ Job& Job::addExecutionBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStage
         0, nullptr,
         0, nullptr,
         0, nullptr);
+    endDebugLabel();
+
+    return *this;
+}
+
+Job& Job::executeSecondaryJobs(const std::vector<Job *> &jobs)
+{
+    if (isSecondary)
+    {
+        throw std::runtime_error("Secondary job can not execute other secondary jobs");
+    }
+
+    for (auto job : jobs)
+    {
+        if (!job->isSecondary || job->commandPool.pool == VK_NULL_HANDLE)
+        {
+            throw std::runtime_error("Only secondary jobs that were not executed yet can be executed by the job");
+        }
+    }
+
+    if (jobs.empty())
+        return *this;
+
+    std::vector<VkCommandBuffer> commandBuffers;
+    for (auto job : jobs)
+    {
+        job->flushBarriers();
+        endCommandBuffer(job->commandBuffer);
+        commandBuffers.push_back(job->commandBuffer);
+    }
+
+    // accesses of the parts are not tracked, so everything recorded before and after them is
+    // synchronized with global barriers
+    addMemoryBarrier(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+    vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+    addMemoryBarrier(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_WRITE_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT);
+    unguardedResourceAccess.clear();
+
+    // host transfers and resources of the parts are completed and released with this job
+    for (auto job : jobs)
+    {
+        preExecutionTransfers.insert(preExecutionTransfers.end(),
+            job->preExecutionTransfers.begin(), job->preExecutionTransfers.end());
+        postExecutionTransfers.insert(postExecutionTransfers.end(),
+            job->postExecutionTransfers.begin(), job->postExecutionTransfers.end());
+        job->preExecutionTransfers.clear();
+        job->postExecutionTransfers.clear();
+
+        usedResources.insert(job->usedResources.begin(), job->usedResources.end());
+        for (const auto &block : job->transientBlocks)
+            usedResources.insert(block.buffer.getLifetime());
+
+        executedCommandPools.push_back(std::exchange(job->commandPool, {}));
+        job->commandBuffer = VK_NULL_HANDLE;
+    }
 
     return *this;
 }
 
 Semaphore Job::submit(bool signal, const std::vector<VkSemaphore>& waitSemaphores)
 {
-    if (!isRecorded)
+    std::lock_guard<std::recursive_mutex> lock(manager->mutex);
+
+    Submission submission = prepareSubmission(signal, waitSemaphores, nullptr);
+
+    vkResetFences(manager->device, 1, &fence);
+
+    if (submission.upload.commandBuffer != VK_NULL_HANDLE)
+    {
+        if (vkQueueSubmit(transferQueue, 1, &submission.upload.getSubmitInfo(), VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to submit upload command buffer!");
+        }
+    }
+
+    bool hasReadback = submission.readback.commandBuffer != VK_NULL_HANDLE;
+    if (vkQueueSubmit(computeQueue, 1, &submission.compute.getSubmitInfo(), hasReadback ? VK_NULL_HANDLE : fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to submit draw command buffer!");
+    }
+
+    if (hasReadback)
     {
-        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        if (vkQueueSubmit(transferQueue, 1, &submission.readback.getSubmitInfo(), fence) != VK_SUCCESS)
         {
-            throw std::runtime_error("failed to record command buffer!");
+            throw std::runtime_error("Failed to submit readback command buffer!");
         }
+    }
+
+    return { signal ? signalSemaphore : VK_NULL_HANDLE };
+}
+
+Job::Submission Job::prepareSubmission(bool signal, const std::vector<VkSemaphore>& waitSemaphores,
+    std::shared_ptr<VkFence> sharedFence)
+{
+    if (isSecondary)
+    {
+        throw std::runtime_error("Secondary job can only be executed by another job");
+    }
+
+    if (!isRecorded)
+    {
+        flushBarriers();
+        endCommandBuffer(commandBuffer);
+        if (uploadCommandBuffer != VK_NULL_HANDLE)
+            endCommandBuffer(uploadCommandBuffer);
+        if (readbackCommandBuffer != VK_NULL_HANDLE)
+            endCommandBuffer(readbackCommandBuffer);
         isRecorded = true;
     }
 
@@ -288,13 +713,70 @@ Semaphore Job::submit(bool signal, const std::vector<VkSemaphore>& waitSemaphore
         throw std::runtime_error("Tried to submit job again without awaiting for its completion");
     }
 
+    Submission submission;
+    submission.compute.commandBuffer = commandBuffer;
+    submission.upload.commandBuffer = uploadCommandBuffer;
+    submission.readback.commandBuffer = readbackCommandBuffer;
+
+    // external semaphores and dependencies are waited by whichever batch is submitted first
+    SubmitBatch &first = uploadCommandBuffer != VK_NULL_HANDLE ? submission.upload : submission.compute;
+    first.waitSemaphores = waitSemaphores;
+    first.waitStages.assign(waitSemaphores.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    first.waitValues.assign(waitSemaphores.size(), 0);
+    for (const auto &dependency : dependencies)
+    {
+        if (dependency.job->timelineSemaphore == VK_NULL_HANDLE)
+        {
+            throw std::runtime_error("Job dependency has to be submitted before the dependent job");
+        }
+        first.waitSemaphores.push_back(dependency.job->timelineSemaphore);
+        // compute stages are not supported by the transfer queue
+        first.waitStages.push_back(uploadCommandBuffer != VK_NULL_HANDLE ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : dependency.waitStage);
+        first.waitValues.push_back(dependency.job->timelineValue);
+        first.useTimelineValues = true;
+    }
+
+    batchFence = std::move(sharedFence);
+
+    if (stagingRegions.size() > 0)
+    {
+        // wait until other jobs are done with the same parts of the shared staging buffer
+        manager->getStagingRingBuffer()->acquire(stagingRegions, getSubmissionFence(), fence);
+    }
+
     completePreExecutionTransfers();
 
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
+    if (uploadCommandBuffer != VK_NULL_HANDLE)
+    {
+        if (uploadSemaphore == VK_NULL_HANDLE)
+        {
+            uploadSemaphore = manager->createSemaphore();
+        }
+
+        submission.upload.signalSemaphores.push_back(uploadSemaphore);
+        submission.upload.signalValues.push_back(0);
+        submission.compute.waitSemaphores.push_back(uploadSemaphore);
+        submission.compute.waitStages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+        submission.compute.waitValues.push_back(0);
+    }
+
+    if (readbackCommandBuffer != VK_NULL_HANDLE)
+    {
+        if (computeSemaphore == VK_NULL_HANDLE)
+        {
+            computeSemaphore = manager->createSemaphore();
+        }
+
+        submission.compute.signalSemaphores.push_back(computeSemaphore);
+        submission.compute.signalValues.push_back(0);
+        submission.readback.waitSemaphores.push_back(computeSemaphore);
+        submission.readback.waitStages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT);
+        submission.readback.waitValues.push_back(0);
+    }
 
+    // semaphores signaled by the last batch of the job
+    SubmitBatch &last = readbackCommandBuffer != VK_NULL_HANDLE ? submission.readback : submission.compute;
     if (signal)
     {
         if (signalSemaphore == VK_NULL_HANDLE)
@@ -302,26 +784,72 @@ Semaphore Job::submit(bool signal, const std::vector<VkSemaphore>& waitSemaphore
             signalSemaphore = manager->createSemaphore();
         }
 
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = &signalSemaphore;
+        last.signalSemaphores.push_back(signalSemaphore);
+        last.signalValues.push_back(0);
     }
 
-    if (waitSemaphores.size() != 0)
+    if (timelineSemaphore == VK_NULL_HANDLE && manager->supportsTimelineSemaphores())
     {
-        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
-        submitInfo.pWaitSemaphores = waitSemaphores.data();
+        // recycled semaphore continues from the value reached by its previous owner
+        timelineSemaphore = manager->createTimelineSemaphore();
+        vkGetSemaphoreCounterValue(manager->device, timelineSemaphore, &timelineValue);
     }
 
-    vkResetFences(manager->device, 1, &fence);
-
-    if (vkQueueSubmit(computeQueue, 1, &submitInfo, fence) != VK_SUCCESS)
+    if (timelineSemaphore != VK_NULL_HANDLE)
     {
-        throw std::runtime_error("Failed to submit draw command buffer!");
+        last.signalSemaphores.push_back(timelineSemaphore);
+        last.signalValues.push_back(++timelineValue);
+        last.useTimelineValues = true;
     }
 
     isSubmitted = true;
 
-    return { signal ? signalSemaphore : VK_NULL_HANDLE };
+    return submission;
+}
+
+void Job::cancelSubmission(bool partlyExecuted)
+{
+    if (partlyExecuted)
+    {
+        // executed parts signaled the semaphores that are never waited, timeline value was
+        // signaled from the host instead of the job
+        uploadSemaphore = VK_NULL_HANDLE;
+        computeSemaphore = VK_NULL_HANDLE;
+    }
+    // job that failed to be prepared has not taken the next timeline value yet
+    else if (isSubmitted && timelineSemaphore != VK_NULL_HANDLE)
+        --timelineValue;
+    batchFence.reset();
+    isSubmitted = false;
+}
+
+VkFence Job::getSubmissionFence() const
+{
+    return batchFence ? *batchFence : fence;
+}
+
+const VkSubmitInfo& Job::SubmitBatch::getSubmitInfo()
+{
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+    submitInfo.pSignalSemaphores = signalSemaphores.data();
+
+    if (useTimelineValues)
+    {
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+        timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+        timelineInfo.pSignalSemaphoreValues = signalValues.data();
+        submitInfo.pNext = &timelineInfo;
+    }
+
+    return submitInfo;
 }
 
 Job& Job::submit()
@@ -331,9 +859,21 @@ Job& Job::submit()
     return *this;
 }
 
+std::future<void> Job::submitAsync(std::function<void(Job &)> callback)
+{
+    submit(false);
+
+    JobManager::AsyncCompletion completion{ this, std::move(callback) };
+    std::future<void> future = completion.promise.get_future();
+    manager->enqueueAsyncCompletion(std::move(completion));
+
+    return future;
+}
+
 bool Job::await(uint64_t timeout)
 {
-    VkResult res = vkWaitForFences(manager->device, 1, &fence, VK_TRUE, timeout);
+    VkFence submissionFence = getSubmissionFence();
+    VkResult res = vkWaitForFences(manager->device, 1, &submissionFence, VK_TRUE, timeout);
     if (res != VK_SUCCESS && res != VK_TIMEOUT)
     {
         throw std::runtime_error("Failed to wait for fence!");
@@ -341,7 +881,14 @@ bool Job::await(uint64_t timeout)
 
     if (res == VK_SUCCESS)
     {
+        resolveProfiledScopes();
         completePostExecutionTransfers();
+        if (stagingRegions.size() > 0)
+        {
+            std::lock_guard<std::recursive_mutex> lock(manager->mutex);
+            // other jobs of the batched submission have not copied their readbacks yet
+            manager->getStagingRingBuffer()->release(submissionFence, fence);
+        }
         isSubmitted = false;
     }
     
@@ -353,11 +900,100 @@ bool Job::isComplete()
     return await(0);
 }
 
+Job& Job::dependsOn(const Job &job, VkPipelineStageFlags waitStage)
+{
+    if (!manager->supportsTimelineSemaphores())
+    {
+        throw std::runtime_error("Job dependencies require timeline semaphores, which are not supported by the device");
+    }
+
+    dependencies.push_back({ &job, waitStage });
+
+    return *this;
+}
+
+uint64_t Job::getTimelineValue() const
+{
+    return timelineValue;
+}
+
+bool Job::wait(uint64_t value, uint64_t timeout) const
+{
+    if (timelineSemaphore == VK_NULL_HANDLE)
+    {
+        throw std::runtime_error("Tried to wait for the job that was never submitted");
+    }
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &timelineSemaphore;
+    waitInfo.pValues = &value;
+
+    VkResult res = vkWaitSemaphores(manager->device, &waitInfo, timeout);
+    if (res != VK_SUCCESS && res != VK_TIMEOUT)
+    {
+        throw std::runtime_error("Failed to wait for semaphore!");
+    }
+
+    return res == VK_SUCCESS;
+}
+
+const std::vector<ProfilingRecord>& Job::getProfilingResults() const
+{
+    return profilingResults;
+}
+
+Job& Job::setUploadData(const Resource &resource, const void *data)
+{
+    if (isSubmitted)
+        throw std::runtime_error("Tried to change host data of the job before awaiting for its completion");
+
+    bool found = false;
+    for (auto &transferInfo : preExecutionTransfers)
+    {
+        if (transferInfo.resource == &resource)
+        {
+            transferInfo.hostBuffer = data;
+            found = true;
+        }
+    }
+    if (!found)
+        throw std::runtime_error("Job has no uploads from the host into the resource");
+
+    return *this;
+}
+
+Job& Job::setReadbackData(const Resource &resource, void *data)
+{
+    if (isSubmitted)
+        throw std::runtime_error("Tried to change host data of the job before awaiting for its completion");
+
+    bool found = false;
+    for (auto &transferInfo : postExecutionTransfers)
+    {
+        if (transferInfo.resource == &resource)
+        {
+            transferInfo.hostBuffer = data;
+            found = true;
+        }
+    }
+    if (!found)
+        throw std::runtime_error("Job has no readbacks from the resource into the host");
+
+    return *this;
+}
+
 VkCommandBuffer Job::getCommandBuffer() const
 {
     return commandBuffer;
 }
 
+JobManager* Job::getManager() const
+{
+    return manager;
+}
+
 void Job::completePostExecutionTransfers()
 {
     for (size_t i = 0; i < postExecutionTransfers.size(); ++i)
@@ -365,7 +1001,8 @@ void Job::completePostExecutionTransfers()
         const auto& transferInfo = postExecutionTransfers[i];
 
         if (transferInfo.hostBuffer != nullptr)
-            manager->copyDataFromHostVisibleMemory(transferInfo.hostBuffer, transferInfo.size, transferInfo.deviceBuffer->GetAllocatedMemory());
+            manager->copyDataFromHostVisibleMemory(transferInfo.hostBuffer, transferInfo.size, transferInfo.deviceBuffer->GetAllocatedMemory(),
+                transferInfo.offset);
 
         if (transferInfo.destroyAfterTransfer)
         {
@@ -386,7 +1023,8 @@ void Job::completePreExecutionTransfers()
         const auto& transferInfo = preExecutionTransfers[i];
 
         if (transferInfo.hostBuffer != nullptr)
-            manager->copyDataToHostVisibleMemory(transferInfo.hostBuffer, transferInfo.size, transferInfo.deviceBuffer->GetAllocatedMemory());
+            manager->copyDataToHostVisibleMemory(transferInfo.hostBuffer, transferInfo.size, transferInfo.deviceBuffer->GetAllocatedMemory(),
+                transferInfo.offset);
 
         if (transferInfo.destroyAfterTransfer)
         {
@@ -400,9 +1038,49 @@ void Job::completePreExecutionTransfers()
     }
 }
 
+void Job::beginCommandBuffer(VkCommandBuffer commandBuffer, bool secondary)
+{
+    // compute commands do not inherit any render pass state
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    // beginInfo.flags;
+    if (secondary)
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to begin recording command buffer!");
+    }
+}
+
+void Job::endCommandBuffer(VkCommandBuffer commandBuffer)
+{
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
+
+VkCommandBuffer Job::getTransferCommandBuffer(VkCommandBuffer &transferCommandBuffer)
+{
+    if (transferCommandBuffer == VK_NULL_HANDLE)
+    {
+        if (transferCommandPool.pool == VK_NULL_HANDLE)
+            transferCommandPool = manager->acquireCommandPool(true);
+        transferCommandBuffer = manager->allocateCommandBuffer(transferCommandPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+        beginCommandBuffer(transferCommandBuffer);
+    }
+
+    return transferCommandBuffer;
+}
+
 void Job::bindPendingResources(const Task &task)
 {
     std::vector<VkDescriptorSet> descriptorSets;
+    std::vector<uint32_t> dynamicOffsets;
     size_t currentFirstPos = pendingBindings.size() > 0 ? pendingBindings.begin()->first : 0;
     for (const auto &[pos, resources]: pendingBindings)
     {
@@ -415,24 +1093,33 @@ void Job::bindPendingResources(const Task &task)
                 static_cast<uint32_t>(currentFirstPos),
                 static_cast<uint32_t>(descriptorSets.size()),
                 descriptorSets.data(),
-                0, nullptr);
+                static_cast<uint32_t>(dynamicOffsets.size()),
+                dynamicOffsets.data());
             
             currentFirstPos = pos;
             descriptorSets.clear();
+            dynamicOffsets.clear();
         }
 
         if (std::holds_alternative<ResourceSet>(resources))
         {
-            descriptorSets.push_back(std::get<ResourceSet>(resources).getDescriptorSet());
+            const auto &set = std::get<ResourceSet>(resources);
+            for (const auto resource : set.getResources())
+                retainResource(*resource);
+            descriptorSets.push_back(set.getDescriptorSet());
+            dynamicOffsets.insert(dynamicOffsets.end(), set.getDynamicOffsets().begin(), set.getDynamicOffsets().end());
         }
         else
         {
             const auto &val = std::get<std::vector<Resource *>>(resources);
-            descriptorSets.push_back(
-                manager->createDescriptorSet(
-                    resourceToDescriptorType(val),
-                    val,
-                    task.getDescriptorSetLayout(pos)));
+            for (const auto resource : val)
+                retainResource(*resource);
+            // bindings declared in the shader decide how the resources are bound
+            const std::vector<ResourceType> noTypes;
+            const auto &types = pos < task.getResourceTypes().size() ? task.getResourceTypes()[pos] : noTypes;
+            descriptorSets.push_back(manager->getCachedDescriptorSet(val, task.getDescriptorSetLayout(pos), types));
+            auto offsets = manager->getDynamicOffsets(val, types);
+            dynamicOffsets.insert(dynamicOffsets.end(), offsets.begin(), offsets.end());
         }
     }
     if (descriptorSets.size() > 0)
@@ -444,7 +1131,8 @@ void Job::bindPendingResources(const Task &task)
             static_cast<uint32_t>(currentFirstPos),
             static_cast<uint32_t>(descriptorSets.size()),
             descriptorSets.data(),
-            0, nullptr);
+            static_cast<uint32_t>(dynamicOffsets.size()),
+            dynamicOffsets.data());
     }
 
     if (pendingConstants.has_value())
@@ -458,18 +1146,170 @@ void Job::bindPendingResources(const Task &task)
             pendingConstants.value().first.get());
     }
 
+    for (const auto &[buffer, accessType] : pendingAddressedBuffers)
+        retainResource(*buffer);
+
     pendingBindings.clear();
+    pendingAddressedBuffers.clear();
     pendingConstants.reset();
 }
 
 void Job::transitionImageLayout(Image &image, VkImageLayout newLayout)
+{
+    queueImageLayoutTransition(image, newLayout);
+    flushBarriers();
+}
+
+void Job::queueImageLayoutTransition(Image &image, VkImageLayout newLayout)
 {
     if (image.getLayout() == newLayout)
         return;
-    manager->transitionImageLayout(commandBuffer, image.getImage(), image.getLayout(), newLayout);
+    if (isSecondary)
+    {
+        // layout is tracked in recording order, which is not the order in which the parts
+        // are executed
+        throw std::runtime_error("Secondary job can not change layouts of the images, they have to be in the general layout already");
+    }
+    hasComputeCommands = true;
+    // layout transition waits for the previous accesses itself
+    unguardedResourceAccess.erase({ ResourceType::StorageImage, (uint64_t)image.getImage() });
+
+    VkImageMemoryBarrier2 barrier = JobManager::makeImageLayoutBarrier(image.getImage(), image.getLayout(), newLayout,
+        image.getMipLevels(), image.getArrayLayers());
+    auto pending = std::find_if(pendingImageBarriers.begin(), pendingImageBarriers.end(),
+        [&barrier](const VkImageMemoryBarrier2 &other) { return other.image == barrier.image; });
+    if (pending != pendingImageBarriers.end())
+    {
+        // no command uses the intermediate layout, so both transitions are done at once
+        pending->newLayout = barrier.newLayout;
+        pending->dstStageMask = barrier.dstStageMask;
+        pending->dstAccessMask = barrier.dstAccessMask;
+    }
+    else
+    {
+        pendingImageBarriers.push_back(barrier);
+    }
     image.setLayout(newLayout);
 }
 
+Job& Job::flushBarriers()
+{
+    if (pendingBufferBarriers.empty() && pendingImageBarriers.empty())
+        return *this;
+
+    // drivers do not track individual buffers, so several buffer barriers are replaced
+    // with a single global barrier for every pair of stages
+    std::vector<VkMemoryBarrier2> memoryBarriers;
+    if (pendingBufferBarriers.size() > 1)
+    {
+        for (const auto &bufferBarrier : pendingBufferBarriers)
+        {
+            auto it = std::find_if(memoryBarriers.begin(), memoryBarriers.end(),
+                [&bufferBarrier](const VkMemoryBarrier2 &barrier) {
+                    return barrier.srcStageMask == bufferBarrier.srcStageMask &&
+                        barrier.dstStageMask == bufferBarrier.dstStageMask;
+                });
+            if (it == memoryBarriers.end())
+            {
+                VkMemoryBarrier2 barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+                barrier.srcStageMask = bufferBarrier.srcStageMask;
+                barrier.dstStageMask = bufferBarrier.dstStageMask;
+                it = memoryBarriers.insert(memoryBarriers.end(), barrier);
+            }
+            it->srcAccessMask |= bufferBarrier.srcAccessMask;
+            it->dstAccessMask |= bufferBarrier.dstAccessMask;
+        }
+        pendingBufferBarriers.clear();
+    }
+
+    beginDebugLabel("Resource barrier");
+    if (manager->supportsSynchronization2())
+    {
+        VkDependencyInfo dependencyInfo{};
+        dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependencyInfo.memoryBarrierCount = static_cast<uint32_t>(memoryBarriers.size());
+        dependencyInfo.pMemoryBarriers = memoryBarriers.size() ? memoryBarriers.data() : nullptr;
+        dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(pendingBufferBarriers.size());
+        dependencyInfo.pBufferMemoryBarriers = pendingBufferBarriers.size() ? pendingBufferBarriers.data() : nullptr;
+        dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(pendingImageBarriers.size());
+        dependencyInfo.pImageMemoryBarriers = pendingImageBarriers.size() ? pendingImageBarriers.data() : nullptr;
+        manager->cmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+    }
+    else
+    {
+        // without synchronization2 all barriers of a single call share the stage masks,
+        // so they wait for the union of the stages
+        VkPipelineStageFlags srcStageMask = 0;
+        VkPipelineStageFlags dstStageMask = 0;
+
+        std::vector<VkMemoryBarrier> legacyMemoryBarriers;
+        for (const auto &barrier : memoryBarriers)
+        {
+            srcStageMask |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+            dstStageMask |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+
+            VkMemoryBarrier legacy{};
+            legacy.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            legacy.srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+            legacy.dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+            legacyMemoryBarriers.push_back(legacy);
+        }
+
+        std::vector<VkBufferMemoryBarrier> legacyBufferBarriers;
+        for (const auto &barrier : pendingBufferBarriers)
+        {
+            srcStageMask |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+            dstStageMask |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+
+            VkBufferMemoryBarrier legacy{};
+            legacy.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            legacy.srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+            legacy.dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+            legacy.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+            legacy.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+            legacy.buffer = barrier.buffer;
+            legacy.offset = barrier.offset;
+            legacy.size = barrier.size;
+            legacyBufferBarriers.push_back(legacy);
+        }
+
+        std::vector<VkImageMemoryBarrier> legacyImageBarriers;
+        for (const auto &barrier : pendingImageBarriers)
+        {
+            srcStageMask |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+            dstStageMask |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+
+            VkImageMemoryBarrier legacy{};
+            legacy.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            legacy.srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+            legacy.dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+            legacy.oldLayout = barrier.oldLayout;
+            legacy.newLayout = barrier.newLayout;
+            legacy.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+            legacy.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+            legacy.image = barrier.image;
+            legacy.subresourceRange = barrier.subresourceRange;
+            legacyImageBarriers.push_back(legacy);
+        }
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            srcStageMask,
+            dstStageMask,
+            0,
+            static_cast<uint32_t>(legacyMemoryBarriers.size()), legacyMemoryBarriers.size() ? legacyMemoryBarriers.data() : nullptr,
+            static_cast<uint32_t>(legacyBufferBarriers.size()), legacyBufferBarriers.size() ? legacyBufferBarriers.data() : nullptr,
+            static_cast<uint32_t>(legacyImageBarriers.size()), legacyImageBarriers.size() ? legacyImageBarriers.data() : nullptr);
+    }
+    endDebugLabel();
+
+    pendingBufferBarriers.clear();
+    pendingImageBarriers.clear();
+
+    return *this;
+}
+
 void Job::checkDataDependencyInPendingBindings(const Task& task)
 {
     if (!autoDataDependencyManagement)
@@ -490,30 +1330,39 @@ void Job::checkDataDependencyInPendingBindings(const Task& task)
         allResources.insert(allResources.end(), rs.begin(), rs.end());
         allAccessFlags.insert(allAccessFlags.end(), accessFlags[pos].begin(), accessFlags[pos].begin() + rs.size());
     }
+    for (const auto &[buffer, accessType] : pendingAddressedBuffers)
+    {
+        allResources.push_back(buffer);
+        allAccessFlags.push_back(accessType);
+    }
 
     checkDataDependency(allResources, Operation::Task, allAccessFlags);
 }
 
 void Job::checkDataDependency(const std::vector<Resource *> &requiredResources,
-    Operation accessStage, AccessTypeFlags accessType)
+    Operation accessStage, AccessTypeFlags accessType, size_t accessSize, size_t accessOffset)
 {
     std::vector<AccessTypeFlags> accessTypes(requiredResources.size(), accessType);
-    checkDataDependency(requiredResources, accessStage, accessTypes);
+    checkDataDependency(requiredResources, accessStage, accessTypes, accessSize, accessOffset);
 }
 
 void Job::checkDataDependency(const std::vector<Resource *> &requiredResources,
-    Operation accessStage, const std::vector<AccessTypeFlags> &accessTypes)
+    Operation accessStage, const std::vector<AccessTypeFlags> &accessTypes, size_t accessSize,
+    size_t accessOffset)
 {
+    hasComputeCommands = true;
+
+    for (size_t i = 0; i < requiredResources.size() && i < accessTypes.size(); ++i)
+    {
+        if ((accessTypes[i] & AccessType::Write) && offloadedReadbacks.count(requiredResources[i]) != 0)
+            throw std::runtime_error("Resource can not be written after it was read back on the transfer queue");
+    }
+
     if (!autoDataDependencyManagement)
         return;
     
     if (requiredResources.size() != accessTypes.size())
         throw std::runtime_error("Number of resources does not match number of elements in accessTypes array");
-    
-    // Different calls for different source stages
-    // TODO switch to synchronization2 ?
-    std::vector<VkBufferMemoryBarrier> shaderStageBarriers;
-    std::vector<VkBufferMemoryBarrier> transferStageBarriers;
 
     // Accumulate access types for every unique resource
     std::map<Resource *, AccessTypeFlags> uniqueResources;
@@ -530,98 +1379,163 @@ void Job::checkDataDependency(const std::vector<Resource *> &requiredResources,
         }
     }
 
+    uint32_t stageBit = 1u << static_cast<uint32_t>(accessStage);
     for (const auto &[resource, accessTypeFlags] : uniqueResources)
     {
-        auto it = unguardedResourceAccess.find(resource);
-        if (it != unguardedResourceAccess.end())
+        if (accessTypeFlags == AccessType::None)
+            continue;
+
+        std::pair<ResourceType, uint64_t> key;
+        ResourceAccesInfo access{ accessTypeFlags, accessStage };
+        if (isBufferResource(resource->getResourceType()))
+        {
+            const auto *buffer = static_cast<const Buffer *>(resource);
+            key = { ResourceType::StorageBuffer, (uint64_t)buffer->getBuffer() };
+            size_t offset = std::min(accessOffset, buffer->getSize());
+            access.offset = buffer->getOffset() + offset;
+            access.size = std::min(accessSize, buffer->getSize() - offset);
+        }
+        else if (isImageResource(resource->getResourceType()))
+        {
+            // sampled and storage images of the same device image share the accesses
+            const auto *image = static_cast<const Image *>(resource);
+            key = { ResourceType::StorageImage, (uint64_t)image->getImage() };
+            access.size = image->getSize();
+        }
+        else
         {
-            const auto &info = it->second;
+            throw std::runtime_error("Unsupported resource type");
+        }
 
-            // two read operations do not require synchronization
-            if (info.accessType == AccessType::Read && accessTypeFlags == AccessType::Read)
+        auto &ranges = unguardedResourceAccess[key];
+        bool isWrite = accessTypeFlags & AccessType::Write;
+        for (auto &previous : ranges)
+        {
+            if (!overlap(previous, access))
                 continue;
 
-            if (info.accessType == AccessType::None || accessTypeFlags == AccessType::None)
+            // two read operations do not require synchronization, and reads of the same
+            // stage after the write wait for it only once
+            bool previousWrite = previous.accessType & AccessType::Write;
+            if (!isWrite && (!previousWrite || (previous.guardedStages & stageBit)))
                 continue;
 
-            if (it->first->getResourceType() == ResourceType::StorageBuffer)
+            addDependencyBarrier(*resource, previous, access);
+            previous.guardedStages |= stageBit;
+        }
+
+        if (isWrite)
+        {
+            // overlapped parts of the previous accesses are guarded by the barriers of this write
+            std::vector<ResourceAccesInfo> remaining;
+            for (const auto &previous : ranges)
             {
-                const auto* buffer = static_cast<const Buffer *>(it->first);
+                if (!overlap(previous, access))
+                {
+                    remaining.push_back(previous);
+                    continue;
+                }
 
-                auto [srcStage, srcAccessMask] = mapStageAndAccessMask(info.accessStage, info.accessType);
-                auto [dstStage, dstAccessMask] = mapStageAndAccessMask(accessStage, accessTypeFlags);
-                
-                if (info.accessStage == Operation::Task)
+                if (previous.offset < access.offset)
                 {
-                    shaderStageBarriers.push_back(makeBufferMemoryBarrier(
-                        *buffer, srcAccessMask, dstAccessMask));
+                    ResourceAccesInfo head = previous;
+                    head.size = access.offset - previous.offset;
+                    remaining.push_back(head);
                 }
-                else if (info.accessStage == Operation::Transfer)
+                if (previous.offset + previous.size > access.offset + access.size)
                 {
-                    transferStageBarriers.push_back(makeBufferMemoryBarrier(
-                        *buffer, srcAccessMask, dstAccessMask));
+                    ResourceAccesInfo tail = previous;
+                    tail.offset = access.offset + access.size;
+                    tail.size = previous.offset + previous.size - tail.offset;
+                    remaining.push_back(tail);
                 }
             }
-            else if (it->first->getResourceType() == ResourceType::StorageImage)
-            {
-                // TODO images
-                throw std::runtime_error("Unsupported resource type");
-            }
-            else
-            {
-                throw std::runtime_error("Unsupported resource type");
-            }
+            remaining.push_back(access);
+            ranges = std::move(remaining);
+        }
+        else if (std::none_of(ranges.begin(), ranges.end(), [&access](const ResourceAccesInfo &previous) {
+                return previous.accessType == access.accessType && previous.accessStage == access.accessStage &&
+                    previous.offset == access.offset && previous.size == access.size;
+            }))
+        {
+            // later writes have to wait for this read as well
+            ranges.push_back(access);
         }
-
-        unguardedResourceAccess.insert_or_assign(resource, ResourceAccesInfo{ accessTypeFlags, accessStage });
     }
+}
 
-    auto dstStage = mapStage(accessStage);
+void Job::addDependencyBarrier(const Resource &resource, const ResourceAccesInfo &previous,
+    const ResourceAccesInfo &access)
+{
+    auto [srcStage, srcAccessMask] = mapStageAndAccessMask(previous.accessStage, previous.accessType);
+    auto [dstStage, dstAccessMask] = mapStageAndAccessMask(access.accessStage, access.accessType);
 
-    if (shaderStageBarriers.size() > 0)
+    // recorded together with other pending barriers before the command itself
+    if (isBufferResource(resource.getResourceType()))
     {
-        addResourceMemoryBarriers(shaderStageBarriers, {}, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStage);
+        const auto &buffer = static_cast<const Buffer &>(resource);
+        size_t begin = std::max(previous.offset, access.offset);
+        size_t end = std::min(previous.offset + previous.size, access.offset + access.size);
+        if (previous.accessType & AccessType::Write)
+        {
+            // whole write is marked as guarded for the stage, so later accesses of its other
+            // parts rely on this barrier as well
+            begin = previous.offset;
+            end = previous.offset + previous.size;
+        }
+        pendingBufferBarriers.push_back(makeBufferMemoryBarrier(
+            buffer.getBuffer(), begin, end - begin, srcStage, srcAccessMask, dstStage, dstAccessMask));
     }
-
-    if (transferStageBarriers.size() > 0)
+    else
     {
-        addResourceMemoryBarriers(transferStageBarriers, {}, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage);
+        // single barrier per image, as the whole image is accessed
+        const auto &image = static_cast<const Image &>(resource);
+        auto barrier = std::find_if(pendingImageBarriers.begin(), pendingImageBarriers.end(),
+            [&image](const VkImageMemoryBarrier2 &other) { return other.image == image.getImage(); });
+        if (barrier == pendingImageBarriers.end())
+        {
+            VkImageMemoryBarrier2 imageBarrier{};
+            imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            imageBarrier.oldLayout = image.getLayout();
+            imageBarrier.newLayout = image.getLayout();
+            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.image = image.getImage();
+            imageBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, image.getMipLevels(), 0, image.getArrayLayers() };
+            barrier = pendingImageBarriers.insert(pendingImageBarriers.end(), imageBarrier);
+        }
+        barrier->srcStageMask |= srcStage;
+        barrier->srcAccessMask |= srcAccessMask;
+        barrier->dstStageMask |= dstStage;
+        barrier->dstAccessMask |= dstAccessMask;
     }
 }
 
-VkBufferMemoryBarrier Job::makeBufferMemoryBarrier(const Buffer &buffer,
-    VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask)
+bool Job::overlap(const ResourceAccesInfo &a, const ResourceAccesInfo &b)
 {
-    VkBufferMemoryBarrier barrier{};
-        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+}
+
+VkBufferMemoryBarrier2 Job::makeBufferMemoryBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+    VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask,
+    VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask)
+{
+    VkBufferMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
         barrier.pNext = nullptr;
+        barrier.srcStageMask = srcStageMask;
         barrier.srcAccessMask = srcAccessMask;
+        barrier.dstStageMask = dstStageMask;
         barrier.dstAccessMask = dstAccessMask;
         barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
         barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.buffer = buffer.getBuffer();
-        barrier.offset = 0;
-        barrier.size = VK_WHOLE_SIZE;
+        barrier.buffer = buffer;
+        barrier.offset = offset;
+        barrier.size = size;
     
     return barrier;
 }
 
-void Job::addResourceMemoryBarriers(
-    const std::vector<VkBufferMemoryBarrier> &bufferBarriers,
-    const std::vector<VkImageMemoryBarrier> &imageBarriers,
-    VkPipelineStageFlags srcStageMask,
-    VkPipelineStageFlags dstStageMask)
-{
-    vkCmdPipelineBarrier(
-        commandBuffer,
-        srcStageMask,
-        dstStageMask,
-        0,
-        0, nullptr,
-        static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.size() ? bufferBarriers.data() : nullptr,
-        static_cast<uint32_t>(imageBarriers.size()), imageBarriers.size() ? imageBarriers.data() : nullptr);
-}
-
 std::pair<VkPipelineStageFlags, VkAccessFlags> Job::mapStageAndAccessMask(Operation accessStage, AccessTypeFlags accessType)
 {
     VkAccessFlags accessFlags = 0;
@@ -643,18 +1557,206 @@ std::pair<VkPipelineStageFlags, VkAccessFlags> Job::mapStageAndAccessMask(Operat
                 accessFlags |= VK_ACCESS_TRANSFER_WRITE_BIT;
             return { VK_PIPELINE_STAGE_TRANSFER_BIT, accessFlags };
         }
+        case Operation::Indirect:
+        {
+            if (accessType & AccessType::Read)
+                accessFlags |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+            return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, accessFlags };
+        }
         default:
             throw std::runtime_error("Unsupported operation");
     }
 }
 
-VkPipelineStageFlags Job::mapStage(Operation accessStage)
+size_t Job::getTransientSize(size_t size) const
 {
-    switch (accessStage)
+    size_t alignment = std::max<size_t>(16, manager->computeLimits.minStorageBufferOffsetAlignment);
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+std::optional<size_t> Job::beginProfiledScope(std::string name, const char *category, bool collectStatistics)
+{
+    // jobs without fence are never awaited, so their queries would never be read
+    bool timestamps = manager->isProfilingEnabled() && fence != VK_NULL_HANDLE;
+    bool statistics = collectStatistics && manager->isPipelineStatisticsEnabled() && fence != VK_NULL_HANDLE;
+    if (!timestamps && !statistics && !manager->areDebugLabelsEnabled())
+        return std::nullopt;
+
+    ProfiledScope scope{ std::move(name), category };
+    beginDebugLabel(scope.name);
+    if (timestamps)
     {
-        case Operation::Task: return VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-        case Operation::Transfer: return VK_PIPELINE_STAGE_TRANSFER_BIT;
-        default:
-            throw std::runtime_error("Unsupported operation");
+        scope.timestampQuery = allocateQueries(VK_QUERY_TYPE_TIMESTAMP, 2);
+        auto [queryPool, query] = getQuery(VK_QUERY_TYPE_TIMESTAMP, *scope.timestampQuery);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, query);
+    }
+    if (statistics)
+    {
+        scope.statisticsQuery = allocateQueries(VK_QUERY_TYPE_PIPELINE_STATISTICS, 1);
+        auto [queryPool, query] = getQuery(VK_QUERY_TYPE_PIPELINE_STATISTICS, *scope.statisticsQuery);
+        vkCmdBeginQuery(commandBuffer, queryPool, query, 0);
+    }
+    profiledScopes.push_back(std::move(scope));
+
+    return profiledScopes.size() - 1;
+}
+
+void Job::endProfiledScope(std::optional<size_t> scope)
+{
+    if (!scope)
+        return;
+
+    const auto &profiledScope = profiledScopes[*scope];
+    if (profiledScope.statisticsQuery)
+    {
+        auto [queryPool, query] = getQuery(VK_QUERY_TYPE_PIPELINE_STATISTICS, *profiledScope.statisticsQuery);
+        vkCmdEndQuery(commandBuffer, queryPool, query);
+    }
+    if (profiledScope.timestampQuery)
+    {
+        auto [queryPool, query] = getQuery(VK_QUERY_TYPE_TIMESTAMP, *profiledScope.timestampQuery + 1);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, query);
+    }
+    endDebugLabel();
+}
+
+void Job::resolveProfiledScopes()
+{
+    profilingResults.clear();
+    if (timestampQueryCount == 0 && statisticsQueryCount == 0)
+        return;
+
+    std::vector<uint64_t> timestamps = readQueries(VK_QUERY_TYPE_TIMESTAMP, timestampQueryCount);
+    std::vector<uint64_t> invocations = readQueries(VK_QUERY_TYPE_PIPELINE_STATISTICS, statisticsQueryCount);
+
+    double period = manager->timestampPeriod;
+    uint64_t mask = manager->timestampMask;
+    for (const auto &scope : profiledScopes)
+    {
+        // scopes that only have debug labels
+        if (!scope.timestampQuery && !scope.statisticsQuery)
+            continue;
+
+        ProfilingRecord record{ scope.name, scope.category };
+        if (scope.timestampQuery)
+        {
+            uint64_t begin = timestamps[*scope.timestampQuery] & mask;
+            uint64_t end = timestamps[*scope.timestampQuery + 1] & mask;
+            record.start = begin * period;
+            record.duration = ((end - begin) & mask) * period;
+        }
+        if (scope.statisticsQuery)
+            record.invocations = invocations[*scope.statisticsQuery];
+        profilingResults.push_back(record);
+    }
+}
+
+uint32_t Job::allocateQueries(VkQueryType type, uint32_t count)
+{
+    auto &pools = type == VK_QUERY_TYPE_PIPELINE_STATISTICS ? statisticsQueryPools : queryPools;
+    auto &used = type == VK_QUERY_TYPE_PIPELINE_STATISTICS ? statisticsQueryCount : timestampQueryCount;
+
+    uint32_t first = used;
+    used += count;
+    while (pools.size() * JobManager::queriesPerPool < used)
+        pools.push_back(manager->createQueryPool(type));
+
+    // queries are reset within the same command buffer, so resubmission needs no host reset
+    auto [queryPool, query] = getQuery(type, first);
+    vkCmdResetQueryPool(commandBuffer, queryPool, query, count);
+
+    return first;
+}
+
+std::pair<VkQueryPool, uint32_t> Job::getQuery(VkQueryType type, uint32_t index) const
+{
+    const auto &pools = type == VK_QUERY_TYPE_PIPELINE_STATISTICS ? statisticsQueryPools : queryPools;
+    return { pools[index / JobManager::queriesPerPool], index % JobManager::queriesPerPool };
+}
+
+std::vector<uint64_t> Job::readQueries(VkQueryType type, uint32_t count) const
+{
+    // results of all used queries of the pool are read at once; queries of a single scope
+    // never cross the pool boundary since pools hold an even number of them
+    std::vector<uint64_t> results(count);
+    for (uint32_t first = 0; first < count; first += JobManager::queriesPerPool)
+    {
+        uint32_t poolCount = std::min(JobManager::queriesPerPool, count - first);
+        VkResult res = vkGetQueryPoolResults(manager->device, getQuery(type, first).first, 0, poolCount,
+            poolCount * sizeof(uint64_t), results.data() + first, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (res != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to get query pool results!");
+        }
     }
+
+    return results;
+}
+
+void Job::beginDebugLabel(const std::string &name)
+{
+    if (!manager->areDebugLabelsEnabled())
+        return;
+
+    VkDebugUtilsLabelEXT label{};
+    label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+    label.pLabelName = name.c_str();
+    manager->cmdBeginDebugUtilsLabel(commandBuffer, &label);
+}
+
+void Job::endDebugLabel()
+{
+    if (manager->areDebugLabelsEnabled())
+        manager->cmdEndDebugUtilsLabel(commandBuffer);
+}
+
+void Job::retainResource(const Resource &resource)
+{
+    if (resource.getLifetime())
+        usedResources.insert(resource.getLifetime());
+}
+
+size_t Job::getTransferSize(const Resource &resource, size_t size, size_t offset)
+{
+    if (!isBufferResource(resource.getResourceType()))
+    {
+        if (offset != 0)
+            throw std::runtime_error("Transfers of the images can not have offsets");
+        return size;
+    }
+
+    if (offset > resource.getSize())
+    {
+        throw std::runtime_error("Transfer starts outside of the buffer");
+    }
+
+    return std::min(size, resource.getSize() - offset);
+}
+
+std::pair<const Buffer *, size_t> Job::getStagingMemory(const Buffer *ownStagingBuffer, size_t size, size_t ownOffset,
+    bool readback)
+{
+    if (ownStagingBuffer != nullptr)
+    {
+        return { ownStagingBuffer, ownOffset };
+    }
+
+    // busy regions of the shared staging buffer are tracked with the job's fence
+    if (fence == VK_NULL_HANDLE)
+    {
+        throw std::runtime_error("Shared staging buffer can not be used by the job without fence");
+    }
+
+    if (manager->settings.stagingBufferSize == 0)
+    {
+        throw std::runtime_error("Resource has neither its own nor shared staging buffer");
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(manager->mutex);
+    StagingRingBuffer *ringBuffer = manager->getStagingRingBuffer();
+    StagingRegion region = ringBuffer->allocate(size, stagingRegions);
+    region.readback = readback;
+    stagingRegions.push_back(region);
+
+    return { &ringBuffer->getBuffer(), stagingRegions.back().offset };
 }
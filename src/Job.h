@@ -2,13 +2,21 @@
 #define JOB_H
 
 #include "Resources.h"
+#include "StagingRingBuffer.h"
+#include "Profiling.h"
 
 #include <vulkan/vulkan.h>
+#include <algorithm>
+#include <array>
 #include <variant>
 #include <memory>
 #include <optional>
 #include <map>
+#include <set>
 #include <vector>
+#include <utility>
+#include <functional>
+#include <future>
 
 class JobManager;
 class Task;
@@ -27,21 +35,97 @@ class Semaphore;
  * however it is not possible to add operations after job was submitted
  * for the first. Job has to be in completed state before it can be
  * submited again.
+ * 
+ * Every job created by JobManager owns its command pools, so different jobs can be
+ * recorded from different threads at the same time. Single job must not be used from
+ * several threads simultaneously.
  */
 class Job
 {
     class JobManager *manager;
 
+    // command pool owned by a single job, so that jobs can be recorded from different threads
+    // without locking; command buffers are kept when the pool is reset and handed out again
+    struct CommandPool
+    {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> primaryCommandBuffers;
+        std::vector<VkCommandBuffer> secondaryCommandBuffers;
+        size_t usedPrimaryCount = 0;
+        size_t usedSecondaryCount = 0;
+    };
+
     VkQueue computeQueue;
+    // pool of the main command buffer, empty for the jobs created for external command buffers
+    CommandPool commandPool;
     VkCommandBuffer commandBuffer;
     VkFence fence;
     VkSemaphore signalSemaphore;
 
+    // Dedicated transfer queue and command buffers that are executed on it
+    // before (uploads) and after (readbacks) the main command buffer
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    CommandPool transferCommandPool;
+    VkCommandBuffer uploadCommandBuffer = VK_NULL_HANDLE;
+    VkCommandBuffer readbackCommandBuffer = VK_NULL_HANDLE;
+    VkSemaphore uploadSemaphore = VK_NULL_HANDLE;
+    VkSemaphore computeSemaphore = VK_NULL_HANDLE;
+
+    // timeline semaphore that reaches timelineValue when the latest submission completes
+    VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+    uint64_t timelineValue = 0;
+
+    struct Dependency
+    {
+        const Job *job;
+        VkPipelineStageFlags waitStage;
+    };
+    std::vector<Dependency> dependencies;
+
+    // fence of the latest submission made with JobManager::submit(), shared with the
+    // other jobs of that submission
+    std::shared_ptr<VkFence> batchFence;
+
+    // single VkSubmitInfo together with the arrays it refers to
+    struct SubmitBatch
+    {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<VkPipelineStageFlags> waitStages;
+        std::vector<uint64_t> waitValues;
+        std::vector<VkSemaphore> signalSemaphores;
+        std::vector<uint64_t> signalValues;
+        bool useTimelineValues = false;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        VkSubmitInfo submitInfo{};
+
+        // batch must not be moved while the returned info is in use
+        const VkSubmitInfo& getSubmitInfo();
+    };
+
+    // upload and readback batches are submitted to the dedicated transfer queue, if the
+    // job has transfers recorded into the corresponding command buffers
+    struct Submission
+    {
+        SubmitBatch upload;
+        SubmitBatch compute;
+        SubmitBatch readback;
+    };
+
     bool isRecorded = false;
     bool isSubmitted = false;
     bool autoDataDependencyManagement = true;
+    // whether anything was recorded into the main command buffer
+    bool hasComputeCommands = false;
+    // recorded into a secondary command buffer and executed by another job
+    bool isSecondary = false;
+    // pools of the secondary jobs executed by this job
+    std::vector<CommandPool> executedCommandPools;
 
     std::map<size_t, std::variant<ResourceSet, std::vector<Resource *>>> pendingBindings;
+    // buffers accessed by the next task through their device addresses
+    std::vector<std::pair<Resource *, AccessTypeFlags>> pendingAddressedBuffers;
     std::optional<std::pair<std::shared_ptr<void>, uint32_t>> pendingConstants;
 
     template <typename T>
@@ -51,6 +135,10 @@ class Job
         size_t size;
         T hostBuffer;
         bool destroyAfterTransfer = false;
+        // offset of the transfered data inside deviceBuffer
+        size_t offset = 0;
+        // resource passed to the sync call, used to replace hostBuffer before resubmission
+        const Resource *resource = nullptr;
     };
     using TransferInfoToHost = TransferInfo<void *>;
     using TransferInfoFromHost = TransferInfo<const void *>;
@@ -63,17 +151,89 @@ class Job
     enum class Operation {
         None,
         Transfer,
-        Task
+        Task,
+        // read of the indirect dispatch arguments
+        Indirect
     };
 
     struct ResourceAccesInfo
     {
         AccessTypeFlags accessType = 0;
         Operation accessStage = Operation::None;
+        // accessed bytes of the underlying buffer, images are tracked as a whole
+        size_t offset = 0;
+        size_t size = 0;
+        // bits of the stages whose later reads already wait for this write
+        uint32_t guardedStages = 0;
+    };
+
+    // information about accesses to the ranges of the underlying buffers and images that
+    // were not synchronised with barrier, keyed by resource type and Vulkan handle, so
+    // that resources sharing memory are tracked together
+    std::map<std::pair<ResourceType, uint64_t>, std::vector<ResourceAccesInfo>> unguardedResourceAccess;
+
+    // barriers of the automatic dependency tracking and image layout transitions that are
+    // recorded together right before the next command that depends on them
+    std::vector<VkBufferMemoryBarrier2> pendingBufferBarriers;
+    std::vector<VkImageMemoryBarrier2> pendingImageBarriers;
+
+    // resources with transfers recorded into the upload/readback command buffers
+    std::set<const Resource*> offloadedUploads;
+    std::set<const Resource*> offloadedReadbacks;
+
+    // regions of the manager's shared staging buffer used by the transfers
+    std::vector<StagingRegion> stagingRegions;
+
+    // keep recorded resources alive until the job is done with them
+    std::set<ResourceLifetime> usedResources;
+
+    struct TransientRange
+    {
+        size_t offset;
+        size_t size;
+        // memory was used by another transient buffer earlier in the recording
+        bool aliased;
     };
 
-    // information about last access to resource that was not synchronised with barrier
-    std::map<const Resource*, ResourceAccesInfo> unguardedResourceAccess;
+    // device-local block that transient buffers are placed into, kept between resets
+    struct TransientBlock
+    {
+        Buffer buffer;
+        // sorted by offset
+        std::vector<TransientRange> freeRanges;
+    };
+    std::vector<TransientBlock> transientBlocks;
+
+    // measured operation; queries are indices over all pools of the corresponding type
+    struct ProfiledScope
+    {
+        std::string name;
+        std::string category;
+        // first of the two consecutive timestamp queries
+        std::optional<uint32_t> timestampQuery;
+        std::optional<uint32_t> statisticsQuery;
+    };
+    // query pools are kept between resets, every pool holds JobManager::queriesPerPool queries
+    std::vector<VkQueryPool> queryPools;
+    std::vector<VkQueryPool> statisticsQueryPools;
+    uint32_t timestampQueryCount = 0;
+    uint32_t statisticsQueryCount = 0;
+    std::vector<ProfiledScope> profiledScopes;
+    std::vector<ProfilingRecord> profilingResults;
+    size_t taskCount = 0;
+
+    // cleared in the moved-from job, so that its objects are returned to the manager only once
+    struct RecycleGuard
+    {
+        bool active = true;
+
+        RecycleGuard() = default;
+        RecycleGuard(RecycleGuard &&other) noexcept : active(std::exchange(other.active, false)) {}
+    };
+    RecycleGuard recycleGuard;
+    uint64_t resourceGeneration = 0;
+
+    friend class JobManager;
 
 public:
     /**
@@ -92,6 +252,32 @@ public:
      */
     Job(JobManager *manager, VkCommandBuffer commandBuffer, VkQueue computeQueue, VkFence fence);
 
+    Job(const Job&) = delete;
+    Job(Job&&) = default;
+    Job& operator=(const Job&) = delete;
+    Job& operator=(Job&&) = delete;
+
+    /**
+     * @brief Destroy the Job object.
+     * 
+     * Command buffers and fence of the job created by JobManager are returned to the
+     * manager to be reused by the new jobs. It is safe to destroy the job that is
+     * still executed on the device, its objects will be reused only after it is done.
+     */
+    ~Job();
+
+    /**
+     * @brief Discard all recorded operations, so that the job can be recorded again.
+     * 
+     * Reuses the same command buffers and fence instead of creating new job. Job must not
+     * be in the submitted state, i.e. await() should be called before the reset. If job
+     * was created for an external command buffer, only internal state is reset and the
+     * command buffer itself has to be reset by its owner.
+     * 
+     * @return Reference to this Job
+     */
+    Job& reset();
+
     /**
      * @brief Set the Auto Data Dependency Management setting.
      * 
@@ -155,6 +341,54 @@ public:
      */
     Job& addTask(const Task &task, const std::vector<ResourceSet> &resources,
         uint32_t groupX, uint32_t groupY = 1, uint32_t groupZ = 1);
+
+    /**
+     * @brief Add task execution over the range of global invocations.
+     * 
+     * Number of workgroups is computed from the local size of the task and rounded up,
+     * so the shader has to skip invocations outside of the range. Ranges that exceed
+     * DeviceComputeLimits::maxComputeWorkGroupCount are split into several dispatches
+     * with base workgroup offsets, which is transparent to the shader.
+     * 
+     * @param task Task that sould be executed on the GPU
+     * @param globalX Number of invocations in the X dimension
+     * @param globalY Number of invocations in the Y dimension
+     * @param globalZ Number of invocations in the Z dimension
+     * @return Reference to this Job
+     */
+    Job& addTaskRange(const Task &task, uint32_t globalX, uint32_t globalY = 1, uint32_t globalZ = 1);
+
+    /**
+     * @brief Add task execution over the range of global invocations.
+     * 
+     * Binds GPU resources (if any provided) to be used in the task and records
+     * dispatches that cover the range (see addTaskRange(const Task&, uint32_t, uint32_t, uint32_t)).
+     * 
+     * @param task Task that sould be executed
+     * @param resources Resources that should be bound to the task and used during
+     * its execution on the GPU. Each element of the vector is interpreted as a separate
+     * ResourceSet (DescriptorSet)
+     * @param globalX Number of invocations in the X dimension
+     * @param globalY Number of invocations in the Y dimension
+     * @param globalZ Number of invocations in the Z dimension
+     * @return Reference to this Job
+     */
+    Job& addTaskRange(const Task &task, const std::vector<std::vector<Resource *>> &resources,
+        uint32_t globalX, uint32_t globalY = 1, uint32_t globalZ = 1);
+
+    /**
+     * @brief Add task execution with the number of workgroups read from the buffer.
+     * 
+     * Records indirect dispatch command into underlying command buffer, so that the
+     * size of the dispatch can be computed by previous tasks of the job without a round
+     * trip to the host. Resources of the task have to be bound with useResources().
+     * 
+     * @param task Task that sould be executed on the GPU
+     * @param args DeviceLocal or DeviceMapped buffer that holds VkDispatchIndirectCommand
+     * @param offset Offset of the command inside \p args in bytes, multiple of 4
+     * @return Reference to this Job
+     */
+    Job& addTaskIndirect(const Task &task, Buffer &args, size_t offset = 0);
     
     /**
      * @brief Bind resources that should be used during the execution of the next
@@ -170,7 +404,10 @@ public:
      * @brief Bind resources that should be used during the execution of the next
      * added task.
      * 
-     * Content of the vector will be turned into single ResourceSet.
+     * Content of the vector will be turned into single ResourceSet. Resources are written
+     * with the types of the bindings declared by the task (see Task::getResourceTypes()).
+     * Dynamic buffers (see TaskCreateInfo::dynamicBindings) are bound with their offsets
+     * passed separately, so ranges of the same size of one buffer reuse a single set.
      * 
      * @param set Set number of the resources to be bound
      * @param resources Array of the resources that should be bound as a single
@@ -179,6 +416,20 @@ public:
      */
     Job& useResources(size_t set, const std::vector<Resource *> &resources);
 
+    /**
+     * @brief Declare buffers that are accessed by the next added task through their device
+     * addresses (see Buffer::getDeviceAddress()) instead of descriptor sets.
+     * 
+     * Buffers are not bound, their addresses have to be passed to the task, e.g. with
+     * pushConstants(). Declaration only keeps the buffers alive until the job is complete
+     * and orders the task with other accesses to them.
+     * 
+     * @param buffers Buffers whose addresses are used by the task
+     * @param accessType How the task accesses the buffers
+     * @return Reference to this Job
+     */
+    Job& useBufferAddresses(const std::vector<Buffer *> &buffers, AccessTypeFlags accessType = AccessType::Read | AccessType::Write);
+
     /**
      * @brief Copy data from the host to the device.
      * 
@@ -190,14 +441,31 @@ public:
      * is minimum between \p size and actual size of the resource. Should be called
      * at least once on every image resource before using it in the task, even if
      * there is no data to copy - in such cases \p data should be set to nullptr.
+     * Host copy is also skipped if \p data is nullptr or points to the mapped memory
+     * of the host-visible buffer that is used for the transfer (see Buffer::data()),
+     * which allows to write data directly into the staging memory.
+     * 
+     * If the manager uses dedicated transfer queue, copies into device-local buffers
+     * that are recorded before any other command of this job are executed on that
+     * queue ahead of the rest of the job.
+     * 
+     * If the manager uses shared staging buffer (see JobManagerSettings::stagingBufferSize),
+     * every transfer into device-local resource uses part of it. Submission of the job
+     * waits for other submitted jobs that use overlapping parts of the buffer.
+     * 
+     * Only \p size bytes starting at \p offset are copied into buffers, both on the host and
+     * on the device, so that small parts of large buffers can be updated without copying the
+     * rest of them (see also BufferView).
      * 
      * @param resource Resource that will be a destination for this copy operation
      * @param data Source for the copy command, allocated on the host. Could be set to
      * nullptr to prepare image layout
      * @param size Amount of bytes to copy
+     * @param offset Offset of the destination range inside the buffer in bytes, must be 0
+     * for images
      * @return Reference to this Job
      */
-    Job& syncResourceToDevice(Resource &resource, const void *data, size_t size = UINT64_MAX);
+    Job& syncResourceToDevice(Resource &resource, const void *data, size_t size = UINT64_MAX, size_t offset = 0);
 
     /**
      * @brief Copy data from the device to the host.
@@ -206,25 +474,99 @@ public:
      * device-local to host-visible momory. Copying from the host-visible to the
      * host memory takes place only on call to await(). Actual amount of bytes
      * that will be copied is minimum between \p size and actual size of the
-     * resource.
+     * resource. If \p data points to the mapped memory of the host-visible buffer
+     * that is used for the transfer (see Buffer::data()), host copy is skipped.
+     * 
+     * If the manager uses dedicated transfer queue, copies from device-local buffers
+     * are executed on that queue after all other commands of this job, so the buffer
+     * must not be written by any command recorded after this call.
+     * 
+     * If the manager uses shared staging buffer (see JobManagerSettings::stagingBufferSize),
+     * data is read back through it, so the job should be awaited before submission of
+     * other jobs that may reuse the same part of the staging buffer.
      * 
      * @param resource Resource that will be a source for this copy operation
      * @param data Destination for the copy command, allocated on the host
      * @param size Amount of bytes to copy
+     * @param offset Offset of the source range inside the buffer in bytes, must be 0 for images
      * @return Reference to this Job
      */
-    Job& syncResourceToHost(Resource &resource, void *data, size_t size = UINT64_MAX);
+    Job& syncResourceToHost(Resource &resource, void *data, size_t size = UINT64_MAX, size_t offset = 0);
+
+    /**
+     * @brief Replace host memory that is copied into the resource on the next submissions.
+     * 
+     * Recorded job can be resubmitted many times without recording it again (see submit()).
+     * Host copies take place outside of the command buffer, so the data of every submission
+     * can be passed as a parameter while the command buffer stays untouched. Per-submission
+     * constants of the tasks can be passed the same way through a Buffer::Type::Uniform
+     * buffer bound to the task, since push constants are recorded into the command buffer.
+     * 
+     * @param resource Resource that was passed to syncResourceToDevice(), all uploads into
+     * it are changed
+     * @param data New source of the copy, must hold at least as many bytes as were recorded
+     * @return Reference to this Job
+     */
+    Job& setUploadData(const Resource &resource, const void *data);
+
+    /**
+     * @brief Replace host memory that receives the data of the resource on the next
+     * submissions.
+     * 
+     * Counterpart of setUploadData() for the transfers recorded with syncResourceToHost().
+     * 
+     * @param resource Resource that was passed to syncResourceToHost(), all readbacks
+     * from it are changed
+     * @param data New destination of the copy, must hold at least as many bytes as were recorded
+     * @return Reference to this Job
+     */
+    Job& setReadbackData(const Resource &resource, void *data);
 
     /**
      * @brief Copy data from one resource to another.
      * 
-     * Copying takes place entirely on the GPU without transfers to/from host.
+     * Copying takes place entirely on the GPU without transfers to/from host. Amount of bytes
+     * copied between buffers is limited by the sizes of both ranges. Offsets must be 0 for images.
      * 
      * @param src Source for copy operation
      * @param dst Destination for copy operation
+     * @param size Amount of bytes to copy between buffers
+     * @param srcOffset Offset of the copied range inside \p src in bytes
+     * @param dstOffset Offset of the copied range inside \p dst in bytes
+     * @return Reference to this Job
+     */
+    Job& syncResources(Resource &src, Resource &dst, size_t size = UINT64_MAX, size_t srcOffset = 0,
+        size_t dstOffset = 0);
+
+    /**
+     * @brief Create device-local buffer for the intermediate data of this job.
+     * 
+     * Transient buffers are placed into the device-local blocks owned by the job (see
+     * JobManagerSettings::transientBlockSize), so no memory is allocated once the job has
+     * enough of it, and binding them costs the same as binding regular buffers. Memory of
+     * the buffers passed to releaseTransientBuffer() is reused by the transient buffers
+     * created afterwards; memory barrier is recorded before the reused memory is accessed
+     * by the new buffer.
+     * 
+     * Transient buffers have no staging buffers of their own, so they can be transferred
+     * to/from host only through the shared staging buffer (see
+     * JobManagerSettings::stagingBufferSize). Buffer stays valid until the job is reset.
+     * 
+     * @param size Size of the buffer in bytes
+     * @return Buffer that refers to the part of the job's block
+     */
+    Buffer createTransientBuffer(size_t size);
+
+    /**
+     * @brief Allow memory of the transient buffer to be reused by the following
+     * createTransientBuffer() calls.
+     * 
+     * The buffer must not be used by the operations recorded after this call.
+     * 
+     * @param buffer Buffer created with createTransientBuffer() of this job
      * @return Reference to this Job
      */
-    Job& syncResources(Resource &src, Resource &dst);
+    Job& releaseTransientBuffer(const Buffer &buffer);
 
     /**
      * @brief Push constants that should be used by the next added task.
@@ -308,6 +650,25 @@ public:
      */
     Job& addExecutionBarrier(VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask);
 
+    /**
+     * @brief Execute commands recorded by the secondary jobs as a part of this job.
+     * 
+     * Allows to split recording of a large job between several threads: every thread
+     * records its part into a job created with JobManager::createSecondaryJob() and the
+     * parts are merged into this job afterwards. Host transfers and resources of the parts
+     * are taken over by this job, so they are completed and released together with it.
+     * 
+     * Accesses of the parts are not tracked by the automatic data dependency management,
+     * instead global memory barriers are recorded before and after the parts. Parts passed
+     * to a single call may be executed concurrently, so they must not write data
+     * that is accessed by other parts; call this function several times to order them.
+     * Passed jobs can only be destroyed afterwards.
+     * 
+     * @param jobs Secondary jobs that were not executed yet
+     * @return Reference to this Job
+     */
+    Job& executeSecondaryJobs(const std::vector<Job *> &jobs);
+
     /**
      * @brief Submit job with all recorded operations to be executed on the GPU.
      * 
@@ -323,6 +684,24 @@ public:
     // TODO
     Job& submit();
 
+    /**
+     * @brief Submit job and complete it on the completion thread of the manager.
+     * 
+     * Instead of blocking in await(), the job is awaited by the thread owned by the
+     * manager, which also completes transfers from device to host, so the calling thread
+     * never waits for the GPU. Once the job is complete, \p callback is called on the
+     * completion thread and then the returned future becomes ready. Exceptions thrown
+     * while completing the job or by the callback are stored in the future.
+     * 
+     * Job must stay alive, must not be moved and must not be used by other threads until
+     * the future is ready. Callback may record new jobs and submit them, including this
+     * one, but must not wait for other jobs submitted with this function.
+     * 
+     * @param callback Function called on the completion thread after the job is complete
+     * @return Future that is ready after the job is complete and the callback returned
+     */
+    std::future<void> submitAsync(std::function<void(Job &)> callback = {});
+
     /**
      * @brief Wait for the GPU to finish operations sumbitted by this job.
      * 
@@ -337,9 +716,66 @@ public:
 
     /**
      * @brief Check whether job is complete. Non-blocking call.
+     * 
+     * Job submitted with JobManager::submit() is considered complete once all jobs of
+     * that submission that finish on the same queue are complete.
      */
     bool isComplete();
 
+    /**
+     * @brief Make this job wait on the GPU for the completion of another job.
+     * 
+     * On every submission this job waits for the latest submission of \p job, which
+     * therefore has to be submitted first. Dependencies are tracked with timeline
+     * semaphores, so any number of jobs can depend on the same job and all of them
+     * can be resubmitted without creating new semaphores. \p job must stay alive and
+     * must not be moved while this job is used. Requires timeline semaphore support
+     * (see JobManager::supportsTimelineSemaphores()).
+     * 
+     * If the manager uses dedicated transfer queue and this job has uploads executed on
+     * that queue, dependencies are waited before the uploads regardless of \p waitStage.
+     * 
+     * @param job Job that has to be completed before this one
+     * @param waitStage Pipeline stages of this job that wait for \p job
+     * @return Reference to this Job
+     */
+    Job& dependsOn(const Job &job, VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+    /**
+     * @brief Get value of the job's timeline that is reached when the latest submission
+     * of the job is completed.
+     * 
+     * Values grow by one with every submission, which allows to wait for specific
+     * submission with wait().
+     */
+    uint64_t getTimelineValue() const;
+
+    /**
+     * @brief Wait until the job's timeline reaches \p value.
+     * 
+     * Unlike await(), does not complete device to host transfers, so the host is blocked
+     * only until the GPU-side work is done. Can be called from any thread.
+     * 
+     * @param value Timeline value to wait for (see getTimelineValue())
+     * @param timeout Timeout period in units of nanoseconds
+     * @return True if the value was reached, false if timeout has expired
+     */
+    bool wait(uint64_t value, uint64_t timeout = UINT64_MAX) const;
+
+    /**
+     * @brief Get GPU times of the tasks and transfers of the latest completed submission.
+     * 
+     * Filled by await() if profiling or pipeline statistics are enabled (see
+     * JobManagerSettings::enableProfiling and JobManagerSettings::enablePipelineStatistics).
+     * Every dispatch recorded with addTask() and every copy recorded into the main command
+     * buffer by syncResourceToDevice(), syncResourceToHost() and syncResources() is
+     * measured. Copies executed on the dedicated transfer queue are not measured. Operations
+     * recorded without barriers between them may overlap.
+     * 
+     * @return Records in the order the operations were recorded
+     */
+    const std::vector<ProfilingRecord>& getProfilingResults() const;
+
     /**
      * @brief Get underlying command buffer.
      * 
@@ -347,6 +783,13 @@ public:
      */
     VkCommandBuffer getCommandBuffer() const;
 
+    /**
+     * @brief Get manager that created the job.
+     * 
+     * @return JobManager*
+     */
+    JobManager* getManager() const;
+
     /**
      * @brief Manually transition image layout.
      * 
@@ -358,6 +801,18 @@ public:
      */
     void transitionImageLayout(Image &image, VkImageLayout layout);
 
+    /**
+     * @brief Record barriers that were accumulated by the automatic synchronization.
+     * 
+     * Barriers between operations of the job and image layout transitions are merged and
+     * recorded right before the command that depends on them. Should be called before
+     * recording commands directly into the command buffer or ending it outside of the
+     * Job class, when integrating job system into external pipeline.
+     * 
+     * @return Reference to this Job
+     */
+    Job& flushBarriers();
+
     /**
      * @brief Complete transfers from device to host.
      * 
@@ -381,28 +836,74 @@ public:
      */
     void completePreExecutionTransfers();
 
+    /**
+     * @brief Split workgroups of a dispatch into parts that do not exceed the limit.
+     * 
+     * Used by addTaskRange(), parts are visited in the order of their base workgroups
+     * with X changing fastest.
+     * 
+     * @param groups Number of workgroups in every dimension
+     * @param maxGroups Maximal number of workgroups of a single dispatch in every dimension
+     * @param dispatch Called with the base workgroup and the number of workgroups of
+     * every part, both as std::array<uint32_t, 3>
+     */
+    template <typename F>
+    static void splitDispatch(const std::array<uint32_t, 3> &groups, const std::array<uint32_t, 3> &maxGroups,
+        F &&dispatch);
+
 private:
+    static void beginCommandBuffer(VkCommandBuffer commandBuffer, bool secondary = false);
+    static void endCommandBuffer(VkCommandBuffer commandBuffer);
+    VkCommandBuffer getTransferCommandBuffer(VkCommandBuffer &transferCommandBuffer);
+    // ownOffset is the offset of the transfered data inside the own staging buffer of the resource
+    std::pair<const Buffer *, size_t> getStagingMemory(const Buffer *ownStagingBuffer, size_t size, size_t ownOffset = 0,
+        bool readback = false);
+    static size_t getTransferSize(const Resource &resource, size_t size, size_t offset);
+    void retainResource(const Resource &resource);
+    size_t getTransientSize(size_t size) const;
+
+    std::optional<size_t> beginProfiledScope(std::string name, const char *category, bool collectStatistics = false);
+    void endProfiledScope(std::optional<size_t> scope);
+    void resolveProfiledScopes();
+    uint32_t allocateQueries(VkQueryType type, uint32_t count);
+    std::pair<VkQueryPool, uint32_t> getQuery(VkQueryType type, uint32_t index) const;
+    std::vector<uint64_t> readQueries(VkQueryType type, uint32_t count) const;
+    void beginDebugLabel(const std::string &name);
+    void endDebugLabel();
+
+    Submission prepareSubmission(bool signal, const std::vector<VkSemaphore>& waitSemaphores,
+        std::shared_ptr<VkFence> sharedFence);
+    // returns the prepared job to the recorded state when its batch is not submitted,
+    // partlyExecuted if some of its command buffers were submitted nevertheless
+    void cancelSubmission(bool partlyExecuted = false);
+    VkFence getSubmissionFence() const;
+
     void bindPendingResources(const Task &);
 
+    std::optional<size_t> prepareDispatch(const Task &task);
+
     void checkDataDependencyInPendingBindings(const Task& task);
 
+    // accessSize and accessOffset limit accessed bytes of the buffers, relative to their offsets
     void checkDataDependency(const std::vector<Resource *> &requiredResources,
-        Operation accessStage, AccessTypeFlags accessType);
+        Operation accessStage, AccessTypeFlags accessType, size_t accessSize = SIZE_MAX, size_t accessOffset = 0);
     
     void checkDataDependency(const std::vector<Resource *> &requiredResources,
-        Operation accessStage, const std::vector<AccessTypeFlags> &accessTypes);
+        Operation accessStage, const std::vector<AccessTypeFlags> &accessTypes, size_t accessSize = SIZE_MAX,
+        size_t accessOffset = 0);
 
-    VkBufferMemoryBarrier makeBufferMemoryBarrier(const Buffer &buffer,
-        VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask);
-    
-    void addResourceMemoryBarriers(
-        const std::vector<VkBufferMemoryBarrier> &bufferBarriers,
-        const std::vector<VkImageMemoryBarrier> &imageBarriers,
-        VkPipelineStageFlags srcStageMask,
-        VkPipelineStageFlags dstStageMask);
+    void addDependencyBarrier(const Resource &resource, const ResourceAccesInfo &previous,
+        const ResourceAccesInfo &access);
+
+    static bool overlap(const ResourceAccesInfo &a, const ResourceAccesInfo &b);
+
+    VkBufferMemoryBarrier2 makeBufferMemoryBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+        VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask,
+        VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask);
+
+    void queueImageLayoutTransition(Image &image, VkImageLayout newLayout);
     
     std::pair<VkPipelineStageFlags, VkAccessFlags> mapStageAndAccessMask(Operation accessStage, AccessTypeFlags accessType);
-    VkPipelineStageFlags mapStage(Operation accessStage);
 };
 
 template <typename T>
@@ -413,4 +914,25 @@ Job& Job::pushConstants(const T &data)
     return *this;
 }
 
+template <typename F>
+void Job::splitDispatch(const std::array<uint32_t, 3> &groups, const std::array<uint32_t, 3> &maxGroups,
+    F &&dispatch)
+{
+    // 64-bit counters do not wrap around when the last part starts close to UINT32_MAX
+    for (uint64_t z = 0; z < groups[2]; z += maxGroups[2])
+    {
+        for (uint64_t y = 0; y < groups[1]; y += maxGroups[1])
+        {
+            for (uint64_t x = 0; x < groups[0]; x += maxGroups[0])
+            {
+                std::array<uint32_t, 3> base = { static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(z) };
+                std::array<uint32_t, 3> count;
+                for (size_t i = 0; i < 3; ++i)
+                    count[i] = std::min(maxGroups[i], groups[i] - base[i]);
+                dispatch(base, count);
+            }
+        }
+    }
+}
+
 #endif // JOB_H
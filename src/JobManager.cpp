@@ -1,9 +1,16 @@
 #include "JobManager.h"
 
 #include "DeviceMemoryAllocator.h"
+#include "StagingRingBuffer.h"
 
 #include <spirv_reflect.h>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <exception>
 
 #ifdef USE_VMA
 using DefaultMemoryAllocator = VMADeviceMemoryAllocator;
@@ -11,8 +18,46 @@ using DefaultMemoryAllocator = VMADeviceMemoryAllocator;
 using DefaultMemoryAllocator = SimpleDeviceMemoryAllocator;
 #endif
 
-JobManager::JobManager(const std::vector<std::string> extensions, DeviceMemoryAllocator* memoryAllocator) :
+// Call func(i) for every i in [0, count) using multiple threads
+template<typename Func>
+static void parallelFor(size_t count, Func func)
+{
+    size_t threadCount = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    std::atomic<size_t> next{ 0 };
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            try
+            {
+                func(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+JobManager::JobManager(const std::vector<std::string> extensions, DeviceMemoryAllocator* memoryAllocator,
+    const JobManagerSettings& settings) :
     manageInstance(true),
+    settings(settings),
     deviceExtensions(extensions),
     allocator(memoryAllocator)
 {
@@ -22,6 +67,8 @@ JobManager::JobManager(const std::vector<std::string> extensions, DeviceMemoryAl
     {
         allocator = new DefaultMemoryAllocator;
     }
+    // vendored VMA does not allocate memory for buffer device addresses
+    bufferDeviceAddressSupported = bufferDeviceAddressSupported && allocator->supportsBufferDeviceAddress();
     if (allocator->initialize(this, physicalDevice, device, instance) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to initialize memory allocator");
@@ -38,127 +85,610 @@ JobManager::JobManager(VkPhysicalDevice physicalDevice, VkDevice device) :
 
 JobManager::~JobManager()
 {
+    joinCompletionThread();
     cleanupVulkan();
 }
 
+// file name of the shader without directories and extension
+static std::string getTaskName(const std::string &shaderPath)
+{
+    size_t begin = shaderPath.find_last_of("/\\");
+    begin = begin == std::string::npos ? 0 : begin + 1;
+    size_t end = shaderPath.find('.', begin);
+    return shaderPath.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+}
+
 Task JobManager::createTask(const std::string &shaderPath)
 {
     return _createTask(shaderPath);
 }
 
+std::vector<Task> JobManager::createTasks(const std::vector<TaskCreateInfo> &taskInfos)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    // load and reflect all new shader modules in parallel
+    std::vector<std::string> newPaths;
+    for (const auto &info : taskInfos)
+    {
+        if (shaderModules.count(info.shaderPath) == 0 &&
+            std::find(newPaths.begin(), newPaths.end(), info.shaderPath) == newPaths.end())
+        {
+            newPaths.push_back(info.shaderPath);
+        }
+    }
+
+    std::vector<ShaderModule> newModules(newPaths.size());
+    auto insertModules = [&]() {
+        for (size_t i = 0; i < newPaths.size(); ++i)
+        {
+            if (newModules[i].vkModule != VK_NULL_HANDLE)
+                shaderModules.insert({ newPaths[i], newModules[i] });
+        }
+    };
+    try
+    {
+        parallelFor(newPaths.size(), [&](size_t i) {
+            newModules[i] = loadShaderModule(newPaths[i]);
+        });
+    }
+    catch (...)
+    {
+        insertModules();
+        throw;
+    }
+    insertModules();
+
+    // collect pipelines that are not in the cache yet
+    std::vector<VkSpecializationInfo> specializationInfos(taskInfos.size());
+    std::vector<std::vector<VkDescriptorSetLayout>> taskLayouts(taskInfos.size());
+    std::vector<std::vector<std::vector<ResourceType>>> taskResourceTypes(taskInfos.size());
+    std::vector<VkPipelineLayout> taskPipelineLayouts(taskInfos.size());
+    std::vector<PipelineKey> taskPipelineKeys;
+
+    std::map<PipelineKey, size_t> newPipelineIndices;
+    std::vector<VkComputePipelineCreateInfo> newPipelineInfos;
+    for (size_t i = 0; i < taskInfos.size(); ++i)
+    {
+        const auto &info = taskInfos[i];
+        ShaderModule &shaderModule = shaderModules.at(info.shaderPath);
+
+        taskResourceTypes[i] = shaderModule.layouts;
+        for (const auto &[set, binding] : info.dynamicBindings)
+        {
+            if (set >= taskResourceTypes[i].size() || binding >= taskResourceTypes[i][set].size())
+                throw std::runtime_error("Dynamic binding is not declared in the shader");
+            ResourceType &type = taskResourceTypes[i][set][binding];
+            if (type == ResourceType::StorageBuffer)
+                type = ResourceType::StorageBufferDynamic;
+            else if (type == ResourceType::UniformBuffer)
+                type = ResourceType::UniformBufferDynamic;
+            else if (!isDynamicResource(type))
+                throw std::runtime_error("Only uniform and storage buffers can be bound as dynamic buffers");
+        }
+
+        for (const auto &descriptorSetLayoutTypes: taskResourceTypes[i])
+        {
+            taskLayouts[i].push_back(createDescriptorSetLayout(descriptorSetLayoutTypes));
+        }
+        taskPipelineLayouts[i] = createPipelineLayout(taskLayouts[i], static_cast<uint32_t>(shaderModule.pushConstantSize));
+
+        VkSpecializationInfo *specializationInfo = nullptr;
+        if (info.specializationMapEntries.size() > 0)
+        {
+            specializationInfo = &specializationInfos[i];
+            specializationInfo->mapEntryCount = static_cast<uint32_t>(info.specializationMapEntries.size());
+            specializationInfo->pMapEntries = info.specializationMapEntries.data();
+            specializationInfo->dataSize = info.specializationData.size();
+            specializationInfo->pData = info.specializationData.data();
+        }
+
+        taskPipelineKeys.push_back(makePipelineKey(shaderModule.vkModule, taskPipelineLayouts[i], specializationInfo));
+        const auto &key = taskPipelineKeys.back();
+        if (pipelines.count(key) == 0 && newPipelineIndices.count(key) == 0)
+        {
+            newPipelineIndices.emplace(key, newPipelineInfos.size());
+            newPipelineInfos.push_back(makeComputePipelineCreateInfo(shaderModule.vkModule, taskPipelineLayouts[i],
+                specializationInfo));
+        }
+    }
+
+    // create new pipelines in batches, one batch per thread
+    std::vector<VkPipeline> newPipelines(newPipelineInfos.size(), VK_NULL_HANDLE);
+    size_t batchCount = std::min<size_t>(newPipelineInfos.size(), std::max(1u, std::thread::hardware_concurrency()));
+    auto insertPipelines = [&]() {
+        for (const auto &[key, index] : newPipelineIndices)
+        {
+            if (newPipelines[index] != VK_NULL_HANDLE)
+                pipelines.emplace(key, newPipelines[index]);
+        }
+    };
+    try
+    {
+        parallelFor(batchCount, [&](size_t batch) {
+            size_t first = newPipelineInfos.size() * batch / batchCount;
+            size_t last = newPipelineInfos.size() * (batch + 1) / batchCount;
+            if (vkCreateComputePipelines(device, pipelineCache, static_cast<uint32_t>(last - first),
+                newPipelineInfos.data() + first, nullptr, newPipelines.data() + first) != VK_SUCCESS)
+            {
+                throw std::runtime_error("Failed to create compute pipeline!");
+            }
+        });
+    }
+    catch (...)
+    {
+        insertPipelines();
+        throw;
+    }
+    insertPipelines();
+
+    std::vector<Task> tasks;
+    for (size_t i = 0; i < taskInfos.size(); ++i)
+    {
+        const ShaderModule &shaderModule = shaderModules.at(taskInfos[i].shaderPath);
+        tasks.push_back({ pipelines.at(taskPipelineKeys[i]), taskPipelineLayouts[i], taskLayouts[i],
+            shaderModule.resourceAccessFlags,
+            taskInfos[i].name.empty() ? getTaskName(taskInfos[i].shaderPath) : taskInfos[i].name,
+            getLocalSize(shaderModule, taskInfos[i].specializationMapEntries.size() > 0 ? &specializationInfos[i] : nullptr),
+            taskResourceTypes[i] });
+    }
+
+    return tasks;
+}
+
 Buffer JobManager::createBuffer(size_t size, Buffer::Type type)
 {
-    VkBuffer buffer;
-    AllocatedMemory bufferMemory;
+    if (type == Buffer::Type::DeviceMapped && !deviceMappedMemorySupported)
+        type = Buffer::Type::DeviceLocal;
+
+    return allocateBuffer(size, type, type == Buffer::Type::DeviceLocal && settings.stagingBufferSize == 0);
+}
+
+Buffer JobManager::allocateBuffer(size_t size, Buffer::Type type, bool withStagingBuffer)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    // destroyed jobs may hold the last references to resources
+    reclaimJobObjects();
+
+    ResourceObjects objects;
     switch(type)
     {
     case Buffer::Type::DeviceLocal:
         createBuffer(
             size,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            buffer,
-            bufferMemory);
+            objects.buffer,
+            objects.memory);
         break;
     case Buffer::Type::Uniform:
         createBuffer(
             size,
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            buffer,
-            bufferMemory);
+            objects.buffer,
+            objects.memory);
         break;
     case Buffer::Type::Staging:
         createBuffer(
             size,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            buffer,
-            bufferMemory,
+            objects.buffer,
+            objects.memory,
             VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
         break;
+    case Buffer::Type::DeviceMapped:
+        createBuffer(
+            size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            objects.buffer,
+            objects.memory);
+        break;
     }
 
-    buffers.push_back(buffer);
-    allocatedMemory.push_back(bufferMemory);
-
     Buffer *staging = nullptr;
-    if (type == Buffer::Type::DeviceLocal)
+    if (withStagingBuffer)
     {
-        VkBuffer stagingBuffer;
-        AllocatedMemory stagingBufferMemory;
         createBuffer(
             size,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            stagingBuffer,
-            stagingBufferMemory,
+            objects.stagingBuffer,
+            objects.stagingMemory,
             VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
         
-        staging = new Buffer(stagingBuffer, stagingBufferMemory, size, Buffer::Type::Staging);
+        // staging buffer is destroyed together with its buffer
+        staging = new Buffer(objects.stagingBuffer, objects.stagingMemory, size, Buffer::Type::Staging);
+    }
 
-        buffers.push_back(stagingBuffer);
-        allocatedMemory.push_back(stagingBufferMemory);
+    VkDeviceAddress deviceAddress = 0;
+    if (bufferDeviceAddressSupported)
+    {
+        VkBufferDeviceAddressInfo addressInfo{};
+        addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+        addressInfo.buffer = objects.buffer;
+        deviceAddress = vkGetBufferDeviceAddress(device, &addressInfo);
     }
 
-    return Buffer{ buffer, bufferMemory, size, type, staging };
+    return Buffer{ objects.buffer, objects.memory, size, type, staging, registerResource(objects), 0, deviceAddress };
 }
 
 Image JobManager::createImage(size_t width, size_t height)
 {
-    VkImage image;
-    AllocatedMemory imageMemory;
-    createImage(static_cast<uint32_t>(width), static_cast<uint32_t>(height),
-        VK_FORMAT_B8G8R8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
-
-    VkImageView imageView = createImageView(image, VK_FORMAT_B8G8R8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
-
-    images.push_back(image);
-    imageViews.push_back(imageView);
-    allocatedMemory.push_back(imageMemory);
-
-    VkBuffer stagingBuffer;
-    AllocatedMemory stagingBufferMemory;
-    size_t imageSize = width * height * 4;
-    createBuffer(
-        imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        stagingBuffer,
-        stagingBufferMemory,
-        VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
-    
-    Buffer *staging = new Buffer(stagingBuffer, stagingBufferMemory, imageSize, Buffer::Type::Staging);
+    return createImage(ImageCreateInfo{ width, height });
+}
 
-    buffers.push_back(stagingBuffer);
-    allocatedMemory.push_back(stagingBufferMemory);
+Image JobManager::createImage(const ImageCreateInfo &info)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    if (info.width == 0 || info.height == 0 || info.arrayLayers == 0)
+        throw std::runtime_error("Image has to have non-zero size and at least one array layer");
+    if (info.mipLevels == 0 || (std::max(info.width, info.height) >> (info.mipLevels - 1)) == 0)
+        throw std::runtime_error("Invalid number of mip levels of the image");
+
+    // image is used in all the ways the device supports for the format
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, info.format, &formatProperties);
+    VkImageUsageFlags usage = 0;
+    if (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)
+        usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    if (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)
+        usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (usage == 0)
+        throw std::runtime_error("Image format can be neither stored nor sampled by the device");
+
+    size_t imageSize = Image::computeSize(info);
+
+    // destroyed jobs may hold the last references to resources
+    reclaimJobObjects();
+
+    checkMemorySoftLimit(static_cast<VkDeviceSize>(imageSize));
+
+    ResourceObjects objects;
+    createImage(static_cast<uint32_t>(info.width), static_cast<uint32_t>(info.height),
+        info.format, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | usage,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, objects.image, objects.memory, info.mipLevels, info.arrayLayers);
+
+    objects.imageView = createImageView(objects.image, info.format, VK_IMAGE_ASPECT_COLOR_BIT,
+        info.mipLevels, info.arrayLayers);
+    VkImageView storageView = objects.imageView;
+    if (info.mipLevels > 1 && (usage & VK_IMAGE_USAGE_STORAGE_BIT))
+    {
+        objects.storageImageView = createImageView(objects.image, info.format, VK_IMAGE_ASPECT_COLOR_BIT,
+            1, info.arrayLayers);
+        storageView = objects.storageImageView;
+    }
 
-    return { image, imageMemory, imageView, width, height, 4, staging };
+    Buffer *staging = nullptr;
+    if (settings.stagingBufferSize == 0)
+    {
+        createBuffer(
+            imageSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            objects.stagingBuffer,
+            objects.stagingMemory,
+            VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+        
+        staging = new Buffer(objects.stagingBuffer, objects.stagingMemory, imageSize, Buffer::Type::Staging);
+    }
+
+    return { objects.image, objects.memory, objects.imageView, storageView, info, staging, VK_IMAGE_LAYOUT_UNDEFINED,
+        registerResource(objects) };
+}
+
+SampledImage JobManager::createSampledImage(const Image &image, VkFilter filter, VkSamplerAddressMode addressMode)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, image.getFormat(), &formatProperties);
+    if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+        throw std::runtime_error("Image format can not be sampled by the device");
+    if (filter == VK_FILTER_LINEAR &&
+        !(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+    {
+        throw std::runtime_error("Image format does not support linear filtering");
+    }
+
+    return { image, getSampler(filter, addressMode) };
+}
+
+VkSampler JobManager::getSampler(VkFilter filter, VkSamplerAddressMode addressMode)
+{
+    auto key = std::make_pair(filter, addressMode);
+    auto it = samplers.find(key);
+    if (it != samplers.end())
+        return it->second;
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = filter;
+    samplerInfo.minFilter = filter;
+    samplerInfo.mipmapMode = filter == VK_FILTER_LINEAR ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = addressMode;
+    samplerInfo.addressModeV = addressMode;
+    samplerInfo.addressModeW = addressMode;
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+    VkSampler sampler;
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create sampler!");
+    }
+    samplers.emplace(key, sampler);
+
+    return sampler;
 }
 
 ResourceSet JobManager::createResourceSet(const std::vector<Resource *> &resources)
 {
-    VkDescriptorSetLayout layout = createDescriptorSetLayout(resourceToDescriptorType(resources));
-    VkDescriptorSet descriptorSet = createDescriptorSet(resourceToDescriptorType(resources), resources, layout);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
 
-    descriptorSetLayouts.push_back(layout);
+    VkDescriptorSetLayout layout = createDescriptorSetLayout(resourceToDescriptorType(resources));
+    VkDescriptorSet descriptorSet = createDescriptorSet(resourceToDescriptorType(resources), resources, layout,
+        descriptorAllocator);
 
     return { descriptorSet, resources };
 }
 
+ResourceSet JobManager::createResourceSet(const Task &task, size_t set, const std::vector<Resource *> &resources)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    const auto &types = task.getResourceTypes().at(set);
+    VkDescriptorSet descriptorSet = createDescriptorSet(resourceToDescriptorType(types), resources,
+        task.getDescriptorSetLayout(set), descriptorAllocator);
+
+    return { descriptorSet, resources, getDynamicOffsets(resources, types) };
+}
+
+TexelBufferView JobManager::createTexelBufferView(const Buffer &buffer, VkFormat format)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    if (buffer.getOffset() % computeLimits.minTexelBufferOffsetAlignment != 0)
+        throw std::runtime_error("Offset of the texel buffer is not a multiple of minTexelBufferOffsetAlignment");
+
+    auto objects = std::find_if(resourceObjects.begin(), resourceObjects.end(), [&buffer](const auto &entry) {
+        return entry.second.buffer == buffer.getBuffer();
+    });
+    if (objects == resourceObjects.end())
+        throw std::runtime_error("Buffer of the texel buffer view was not created by the manager");
+
+    auto key = std::make_tuple(format, buffer.getOffset(), buffer.getSize());
+    auto it = objects->second.bufferViews.find(key);
+    if (it == objects->second.bufferViews.end())
+    {
+        VkBufferViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO;
+        viewInfo.buffer = buffer.getBuffer();
+        viewInfo.format = format;
+        viewInfo.offset = buffer.getOffset();
+        viewInfo.range = buffer.getSize();
+
+        VkBufferView view;
+        if (vkCreateBufferView(device, &viewInfo, nullptr, &view) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create buffer view!");
+        }
+        it = objects->second.bufferViews.emplace(key, view).first;
+    }
+
+    return { buffer, it->second, format };
+}
+
 Job JobManager::createJob(VkCommandBuffer commandBuffer)
 {
     if (commandBuffer != VK_NULL_HANDLE)
         return { this, commandBuffer, VK_NULL_HANDLE, VK_NULL_HANDLE };
     
-    auto fence = createFence();
-    commandBuffer = createCommandBuffer();
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    reclaimJobObjects();
 
-    fences.push_back(fence);
+    VkFence fence = acquireFence();
+    Job::CommandPool pool = acquireCommandPool(false);
+    commandBuffer = allocateCommandBuffer(pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+    Job job(this, commandBuffer, computeQueue, fence);
+    job.commandPool = std::move(pool);
+
+    return job;
+}
+
+Job JobManager::createSecondaryJob()
+{
+    Job::CommandPool pool = acquireCommandPool(false);
+    VkCommandBuffer commandBuffer = allocateCommandBuffer(pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+    // job has neither queue nor fence, so it is not started by the constructor
+    Job job(this, commandBuffer, VK_NULL_HANDLE, VK_NULL_HANDLE);
+    job.commandPool = std::move(pool);
+    job.isSecondary = true;
+    Job::beginCommandBuffer(commandBuffer, true);
+
+    return job;
+}
+
+void JobManager::submit(const std::vector<Job *> &jobs)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    // whole batch is checked before any job is prepared, so a rejected batch leaves all
+    // jobs untouched
+    for (auto it = jobs.begin(); it != jobs.end(); ++it)
+    {
+        Job *job = *it;
+        if (job->isSecondary)
+        {
+            throw std::runtime_error("Secondary job can only be executed by another job");
+        }
+
+        if (job->isSubmitted || std::find(jobs.begin(), it, job) != it)
+        {
+            throw std::runtime_error("Tried to submit job again without awaiting for its completion");
+        }
+
+        for (const auto &dependency : job->dependencies)
+        {
+            auto position = std::find(jobs.begin(), jobs.end(), dependency.job);
+            bool submittedBefore = position == jobs.end() ? dependency.job->timelineSemaphore != VK_NULL_HANDLE : position < it;
+            if (!submittedBefore)
+            {
+                throw std::runtime_error("Job dependency has to be submitted before the dependent job");
+            }
+        }
+
+        // jobs ending on different queues do not share the fence, which would otherwise
+        // detect the overlap when the regions are acquired
+        for (const auto &region : job->stagingRegions)
+        {
+            bool overlaps = std::any_of(jobs.begin(), it, [&region](const Job *previous) {
+                return std::any_of(previous->stagingRegions.begin(), previous->stagingRegions.end(), [&region](const StagingRegion &other) {
+                    return StagingRingBuffer::overlap(region, other);
+                });
+            });
+            if (overlaps)
+            {
+                throw std::runtime_error("Transfers of the batched jobs do not fit into the staging buffer");
+            }
+        }
+    }
+
+    // jobs with readbacks on the dedicated transfer queue are completed by the separate submission
+    std::shared_ptr<VkFence> computeFence;
+    std::shared_ptr<VkFence> readbackFence;
+    std::vector<Job::Submission> submissions;
+    submissions.reserve(jobs.size());
+    try
+    {
+        for (auto job : jobs)
+        {
+            auto &sharedFence = job->readbackCommandBuffer != VK_NULL_HANDLE ? readbackFence : computeFence;
+            if (!sharedFence)
+            {
+                sharedFence = createSharedFence();
+            }
+
+            submissions.push_back(job->prepareSubmission(false, {}, sharedFence));
+        }
+    }
+    catch (...)
+    {
+        for (auto sharedFence : { &computeFence, &readbackFence })
+            cancelBatch(jobs, *sharedFence, VK_NULL_HANDLE);
+        throw;
+    }
+
+    std::vector<VkSubmitInfo> uploadInfos;
+    std::vector<VkSubmitInfo> computeInfos;
+    std::vector<VkSubmitInfo> readbackInfos;
+    for (auto &submission : submissions)
+    {
+        if (submission.upload.commandBuffer != VK_NULL_HANDLE)
+            uploadInfos.push_back(submission.upload.getSubmitInfo());
+        computeInfos.push_back(submission.compute.getSubmitInfo());
+        if (submission.readback.commandBuffer != VK_NULL_HANDLE)
+            readbackInfos.push_back(submission.readback.getSubmitInfo());
+    }
 
-    return { this, commandBuffer, computeQueue, fence };
+    // fences are reset right before their submission, so the fences of the batches that
+    // are not submitted stay signaled
+    if (uploadInfos.size() > 0)
+    {
+        if (vkQueueSubmit(transferQueue, static_cast<uint32_t>(uploadInfos.size()), uploadInfos.data(), VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            for (auto sharedFence : { &computeFence, &readbackFence })
+                cancelBatch(jobs, *sharedFence, VK_NULL_HANDLE);
+            throw std::runtime_error("Failed to submit upload command buffer!");
+        }
+    }
+
+    if (computeInfos.size() > 0)
+    {
+        if (computeFence)
+            vkResetFences(device, 1, computeFence.get());
+        if (vkQueueSubmit(computeQueue, static_cast<uint32_t>(computeInfos.size()), computeInfos.data(),
+            computeFence ? *computeFence : VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            VkQueue startedQueue = uploadInfos.size() > 0 ? transferQueue : VK_NULL_HANDLE;
+            for (auto sharedFence : { &computeFence, &readbackFence })
+                cancelBatch(jobs, *sharedFence, startedQueue);
+            throw std::runtime_error("Failed to submit draw command buffer!");
+        }
+    }
+
+    if (readbackInfos.size() > 0)
+    {
+        vkResetFences(device, 1, readbackFence.get());
+        if (vkQueueSubmit(transferQueue, static_cast<uint32_t>(readbackInfos.size()), readbackInfos.data(), *readbackFence) != VK_SUCCESS)
+        {
+            // jobs without readbacks are submitted completely
+            cancelBatch(jobs, readbackFence, computeQueue);
+            throw std::runtime_error("Failed to submit readback command buffer!");
+        }
+    }
+}
+
+void JobManager::cancelBatch(const std::vector<Job *> &jobs, std::shared_ptr<VkFence> &fence, VkQueue startedQueue)
+{
+    if (!fence)
+        return;
+
+    std::vector<Job *> cancelled;
+    for (auto job : jobs)
+    {
+        if (job->batchFence == fence)
+            cancelled.push_back(job);
+    }
+
+    if (startedQueue != VK_NULL_HANDLE)
+    {
+        // submitted parts of the batch may wait for the cancelled jobs, their timeline values
+        // are signaled so that the queue can finish them before the staging regions are freed
+        for (auto job : cancelled)
+        {
+            if (job->isSubmitted && job->timelineSemaphore != VK_NULL_HANDLE)
+            {
+                VkSemaphoreSignalInfo signalInfo{};
+                signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+                signalInfo.semaphore = job->timelineSemaphore;
+                signalInfo.value = job->timelineValue;
+                vkSignalSemaphore(device, &signalInfo);
+            }
+        }
+        vkQueueWaitIdle(startedQueue);
+    }
+
+    if (stagingRingBuffer)
+        stagingRingBuffer->release(*fence);
+    for (auto job : cancelled)
+        job->cancelSubmission(startedQueue != VK_NULL_HANDLE);
+
+    if (vkGetFenceStatus(device, *fence) != VK_SUCCESS)
+    {
+        // fence that was reset for the failed submission is replaced by a signaled one, since
+        // the pool expects signaled fences
+        VkFence replacement = createFence();
+        vkDestroyFence(device, *fence, nullptr);
+        std::replace(fences.begin(), fences.end(), *fence, replacement);
+        *fence = replacement;
+    }
 }
 
 VkDevice JobManager::getDevice()
@@ -176,18 +706,100 @@ DeviceComputeLimits JobManager::getComputeLimits()
     return computeLimits;
 }
 
+size_t JobManager::getSuitableDeviceCount() const
+{
+    return suitableDeviceCount;
+}
+
+VkPhysicalDeviceProperties JobManager::getDeviceProperties() const
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    return properties;
+}
+
+bool JobManager::supportsTimelineSemaphores() const
+{
+    return timelineSemaphoresSupported;
+}
+
+bool JobManager::supportsMemoryBudget() const
+{
+    return memoryBudgetSupported;
+}
+
+bool JobManager::supportsBufferDeviceAddress() const
+{
+    return bufferDeviceAddressSupported;
+}
+
+bool JobManager::supportsSynchronization2() const
+{
+    return synchronization2Supported;
+}
+
+bool JobManager::supportsDeviceMappedBuffers() const
+{
+    return deviceMappedMemorySupported;
+}
+
+bool JobManager::isProfilingEnabled() const
+{
+    return settings.enableProfiling && timestampsSupported;
+}
+
+bool JobManager::isPipelineStatisticsEnabled() const
+{
+    return pipelineStatisticsSupported;
+}
+
+bool JobManager::areDebugLabelsEnabled() const
+{
+    return cmdBeginDebugUtilsLabel != nullptr && cmdEndDebugUtilsLabel != nullptr;
+}
+
+std::vector<MemoryHeapStatistics> JobManager::getMemoryStatistics()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    return allocator->getHeapStatistics();
+}
+
+size_t JobManager::getCachedDescriptorPoolCount() const
+{
+    return cachedDescriptorAllocator.getPoolCount();
+}
+
+void JobManager::clearDescriptorSetCache()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    descriptorSetCache.clear();
+    cachedDescriptorAllocator.reset();
+}
+
+bool JobManager::hasDedicatedTransferQueue() const
+{
+    return transferQueue != VK_NULL_HANDLE && queueFamilyIndices.transferFamily != queueFamilyIndices.computeFamily;
+}
+
 void JobManager::initVulkan()
 {
     if (manageInstance)
     {
         createInstance();
         setupDebugMessenger();
+        loadDebugLabelFunctions();
         pickPhysicalDevice();
         createLogicalDevice();
     }
     cacheComputeLimits();
-    createCommandPool();
-    createDescriptorPool();
+    cacheMemoryProperties();
+    createPipelineCache();
+    queueFamilyIndices = findQueueFamilies(physicalDevice);
+    cacheTimestampProperties();
+    createDescriptorAllocators();
 }
 
 void JobManager::cleanupVulkan()
@@ -196,8 +808,11 @@ void JobManager::cleanupVulkan()
 
     allocator->deinitialize();
 
-    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
-    vkDestroyCommandPool(device, commandPool, nullptr);
+    savePipelineCache();
+    vkDestroyPipelineCache(device, pipelineCache, nullptr);
+
+    descriptorAllocator.destroy();
+    cachedDescriptorAllocator.destroy();
 
     for (const auto& [key, shaderModule] : shaderModules)
         vkDestroyShaderModule(device, shaderModule.vkModule, nullptr);
@@ -218,6 +833,15 @@ void JobManager::cleanupVulkan()
 
 void JobManager::cleanupResources()
 {
+    // underlying buffer is destroyed below along with the others
+    stagingRingBuffer.reset();
+
+    freeCommandBufferPools();
+    ++resourceGeneration;
+
+    clearDescriptorSetCache();
+    descriptorAllocator.reset();
+
     for (auto fence: fences)
         vkDestroyFence(device, fence, nullptr);
     fences.clear();
@@ -226,33 +850,32 @@ void JobManager::cleanupResources()
         vkDestroySemaphore(device, semaphore, nullptr);
     semaphores.clear();
 
-    for (auto buffer: buffers)
-        vkDestroyBuffer(device, buffer, nullptr);
-    buffers.clear();
-    
-    for (auto imageView: imageViews)
-        vkDestroyImageView(device, imageView, nullptr);
-    imageViews.clear();
-    
-    for (auto image: images)
-        vkDestroyImage(device, image, nullptr);
-    images.clear();
-    
-    for (auto memory: allocatedMemory)
-        allocator->freeMemory(memory);
-    allocatedMemory.clear();
+    // query pools of both types are destroyed here
+    for (auto queryPool: queryPools)
+        vkDestroyQueryPool(device, queryPool, nullptr);
+    queryPools.clear();
+
+    // handles that are still alive are detached from the destroyed objects
+    resourceOwner = std::make_shared<JobManager *>(this);
+    for (const auto& [key, objects]: resourceObjects)
+        destroyResourceObjects(objects);
+    resourceObjects.clear();
 
-    for (auto pipeline: pipelines)
+    for (const auto& [key, pipeline]: pipelines)
         vkDestroyPipeline(device, pipeline, nullptr);
     pipelines.clear();
     
-    for (auto pipelineLayout: pipelineLayouts)
+    for (const auto& [key, pipelineLayout]: pipelineLayouts)
         vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
     pipelineLayouts.clear();
 
-    for (auto descriptorSetLayout: descriptorSetLayouts)
+    for (const auto& [key, descriptorSetLayout]: descriptorSetLayouts)
         vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
     descriptorSetLayouts.clear();
+
+    for (const auto& [key, sampler]: samplers)
+        vkDestroySampler(device, sampler, nullptr);
+    samplers.clear();
 }
 
 void JobManager::createInstance()
@@ -268,7 +891,7 @@ void JobManager::createInstance()
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_1;
+    appInfo.apiVersion = VK_API_VERSION_1_2;
 
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -333,7 +956,7 @@ std::vector<const char*> JobManager::getRequiredExtensions()
 {
     std::vector<const char*> extensions;
 
-    if (enableValidationLayers)
+    if (enableValidationLayers || (settings.enableDebugLabels && checkInstanceExtensionSupport(VK_EXT_DEBUG_UTILS_EXTENSION_NAME)))
     {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
@@ -341,6 +964,33 @@ std::vector<const char*> JobManager::getRequiredExtensions()
     return extensions;
 }
 
+bool JobManager::checkInstanceExtensionSupport(const char *extensionName)
+{
+    uint32_t extensionCount;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto& extension : availableExtensions)
+    {
+        if (strcmp(extensionName, extension.extensionName) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+void JobManager::loadDebugLabelFunctions()
+{
+    if (!settings.enableDebugLabels)
+        return;
+
+    // null if the extension was not enabled, in which case labels are not recorded
+    cmdBeginDebugUtilsLabel = (PFN_vkCmdBeginDebugUtilsLabelEXT) vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT");
+    cmdEndDebugUtilsLabel = (PFN_vkCmdEndDebugUtilsLabelEXT) vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT");
+}
+
 void JobManager::populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo)
 {
     createInfo = {};
@@ -377,19 +1027,49 @@ void JobManager::pickPhysicalDevice()
     std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
 
+    std::vector<VkPhysicalDevice> suitableDevices;
     for (const auto& device: devices)
     {
         if (isDeviceSuitable(device))
-        {
-            physicalDevice = device;
-            break;
-        }
+            suitableDevices.push_back(device);
     }
 
-    if (physicalDevice == VK_NULL_HANDLE)
+    if (suitableDevices.empty())
     {
         throw std::runtime_error("failed to find a suitable GPU!");
     }
+
+    // devices with equal score keep the order of enumeration
+    std::stable_sort(suitableDevices.begin(), suitableDevices.end(), [](VkPhysicalDevice a, VkPhysicalDevice b) {
+        return getDeviceScore(a) > getDeviceScore(b);
+    });
+    suitableDeviceCount = suitableDevices.size();
+
+    if (settings.deviceIndex >= suitableDevices.size())
+    {
+        throw std::runtime_error("Device index is out of range of the suitable GPUs");
+    }
+    physicalDevice = suitableDevices[settings.deviceIndex];
+}
+
+uint64_t JobManager::getDeviceScore(VkPhysicalDevice device)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+
+    uint64_t deviceLocalSize = 0;
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+    {
+        if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            deviceLocalSize += memoryProperties.memoryHeaps[i].size;
+    }
+
+    // heap sizes stay far below 2^62 bytes
+    uint64_t typeScore = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU ? 2 :
+        properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ? 1 : 0;
+    return (typeScore << 62) | std::min<uint64_t>(deviceLocalSize, (1ull << 62) - 1);
 }
 
 void JobManager::createLogicalDevice()
@@ -413,18 +1093,99 @@ void JobManager::createLogicalDevice()
     VkPhysicalDeviceFeatures deviceFeatures{};
     // deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    auto isExtensionAvailable = [&availableExtensions](const char *name) {
+        return std::any_of(availableExtensions.begin(), availableExtensions.end(),
+            [name](const VkExtensionProperties &extension) {
+                return std::string(extension.extensionName) == name;
+            });
+    };
+
+    VkPhysicalDeviceSynchronization2Features synchronization2Features{};
+    synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES;
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures{};
+    bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+    bool synchronization2Available = isExtensionAvailable(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    if (synchronization2Available)
+        timelineFeatures.pNext = &synchronization2Features;
+    // extension is enabled also on Vulkan 1.2 devices, since allocators are set up for Vulkan 1.1
+    bool bufferDeviceAddressAvailable = settings.enableBufferDeviceAddress &&
+        isExtensionAvailable(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+    if (bufferDeviceAddressAvailable)
+    {
+        bufferDeviceAddressFeatures.pNext = timelineFeatures.pNext;
+        timelineFeatures.pNext = &bufferDeviceAddressFeatures;
+    }
+    VkPhysicalDeviceFeatures2 features2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &timelineFeatures;
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &features2);
+
+    pipelineStatisticsSupported = settings.enablePipelineStatistics && features2.features.pipelineStatisticsQuery;
+    deviceFeatures.pipelineStatisticsQuery = pipelineStatisticsSupported ? VK_TRUE : VK_FALSE;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    timelineSemaphoresSupported = properties.apiVersion >= VK_API_VERSION_1_2 && timelineFeatures.timelineSemaphore;
+    synchronization2Supported = synchronization2Available && synchronization2Features.synchronization2;
+    bufferDeviceAddressSupported = bufferDeviceAddressAvailable && bufferDeviceAddressFeatures.bufferDeviceAddress;
+
+    // budget is only used for statistics, so the extension is enabled whenever it is available
+    memoryBudgetSupported = isExtensionAvailable(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    void *featuresChain = nullptr;
+    if (synchronization2Supported)
+    {
+        synchronization2Features.pNext = featuresChain;
+        featuresChain = &synchronization2Features;
+    }
+    if (timelineSemaphoresSupported)
+    {
+        timelineFeatures.pNext = featuresChain;
+        featuresChain = &timelineFeatures;
+    }
+    if (bufferDeviceAddressSupported)
+    {
+        // only the addresses themselves are needed
+        bufferDeviceAddressFeatures.bufferDeviceAddressCaptureReplay = VK_FALSE;
+        bufferDeviceAddressFeatures.bufferDeviceAddressMultiDevice = VK_FALSE;
+        bufferDeviceAddressFeatures.pNext = featuresChain;
+        featuresChain = &bufferDeviceAddressFeatures;
+    }
+    createInfo.pNext = featuresChain;
 
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     std::vector<const char*> extensions;
     for (const auto &ext: deviceExtensions)
         extensions.push_back(ext.data());
+    if (memoryBudgetSupported && std::find(deviceExtensions.begin(), deviceExtensions.end(),
+        VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == deviceExtensions.end())
+    {
+        extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+    if (synchronization2Supported && std::find(deviceExtensions.begin(), deviceExtensions.end(),
+        VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME) == deviceExtensions.end())
+    {
+        extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    }
+    if (bufferDeviceAddressSupported && std::find(deviceExtensions.begin(), deviceExtensions.end(),
+        VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME) == deviceExtensions.end())
+    {
+        extensions.push_back(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+    }
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
 
     if (enableValidationLayers)
@@ -442,7 +1203,15 @@ void JobManager::createLogicalDevice()
         throw std::runtime_error("failed to create logical device!");
     }
 
+    if (synchronization2Supported)
+    {
+        cmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2KHR) vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR");
+        synchronization2Supported = cmdPipelineBarrier2 != nullptr;
+    }
+
     vkGetDeviceQueue(device, indices.computeFamily.value(), 0, &computeQueue);
+    if (indices.transferFamily != indices.computeFamily)
+        vkGetDeviceQueue(device, indices.transferFamily.value(), 0, &transferQueue);
 }
 
 bool JobManager::isDeviceSuitable(VkPhysicalDevice device)
@@ -489,10 +1258,65 @@ void JobManager::cacheComputeLimits()
         computeLimits.maxComputeWorkGroupCount);
     std::copy(deviceProperties.limits.maxComputeWorkGroupSize, deviceProperties.limits.maxComputeWorkGroupSize + 3,
         computeLimits.maxComputeWorkGroupSize);
+    computeLimits.minStorageBufferOffsetAlignment = deviceProperties.limits.minStorageBufferOffsetAlignment;
+    computeLimits.minUniformBufferOffsetAlignment = deviceProperties.limits.minUniformBufferOffsetAlignment;
+    computeLimits.minTexelBufferOffsetAlignment = deviceProperties.limits.minTexelBufferOffsetAlignment;
+
+    // suitable devices support Vulkan 1.1, so subgroup properties are always available
+    VkPhysicalDeviceSubgroupProperties subgroupProperties{};
+    subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &subgroupProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+    computeLimits.subgroupSize = subgroupProperties.subgroupSize;
+    computeLimits.subgroupOperations = (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) ?
+        subgroupProperties.supportedOperations : 0;
+}
+
+void JobManager::cacheTimestampProperties()
+{
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+    timestampPeriod = deviceProperties.limits.timestampPeriod;
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    uint32_t validBits = queueFamilies[queueFamilyIndices.computeFamily.value()].timestampValidBits;
+    timestampsSupported = validBits > 0;
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+}
+
+void JobManager::cacheMemoryProperties()
+{
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    // without resizable BAR such memory is limited to a 256 MiB window, which is better left
+    // to the driver than exhausted by buffers
+    constexpr VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    constexpr VkDeviceSize legacyBarSize = 256 * 1024 * 1024;
+    deviceMappedMemorySupported = false;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        const VkMemoryType &type = memoryProperties.memoryTypes[i];
+        if ((type.propertyFlags & flags) == flags && memoryProperties.memoryHeaps[type.heapIndex].size > legacyBarSize)
+            deviceMappedMemorySupported = true;
+    }
 }
 
 VkDescriptorSetLayout JobManager::createDescriptorSetLayout(std::vector<VkDescriptorType> types)
 {
+    auto it = descriptorSetLayouts.find(types);
+    if (it != descriptorSetLayouts.end())
+    {
+        return it->second;
+    }
+
     // TODO
     std::vector<VkDescriptorSetLayoutBinding> bindings;
 
@@ -518,6 +1342,8 @@ VkDescriptorSetLayout JobManager::createDescriptorSetLayout(std::vector<VkDescri
         throw std::runtime_error("failed to create descriptor set layout!");
     }
 
+    descriptorSetLayouts.emplace(types, descriptorSetLayout);
+
     return descriptorSetLayout;
 }
 
@@ -533,6 +1359,13 @@ VkDescriptorSetLayout JobManager::createDescriptorSetLayout(std::vector<Resource
 VkPipelineLayout JobManager::createPipelineLayout(const std::vector<VkDescriptorSetLayout> &descriptorSetLayouts,
     uint32_t pushConstantSize)
 {
+    auto key = std::make_pair(descriptorSetLayouts, pushConstantSize);
+    auto it = pipelineLayouts.find(key);
+    if (it != pipelineLayouts.end())
+    {
+        return it->second;
+    }
+
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
@@ -553,11 +1386,54 @@ VkPipelineLayout JobManager::createPipelineLayout(const std::vector<VkDescriptor
         throw std::runtime_error("Failed to create pipeline layout!");
     }
 
+    pipelineLayouts.emplace(std::move(key), pipelineLayout);
+
     return pipelineLayout;
 }
 
 VkPipeline JobManager::createComputePipeline(VkShaderModule vkModule, VkPipelineLayout pipelineLayout,
     VkSpecializationInfo *specializationInfo)
+{
+    auto key = makePipelineKey(vkModule, pipelineLayout, specializationInfo);
+    auto it = pipelines.find(key);
+    if (it != pipelines.end())
+    {
+        return it->second;
+    }
+
+    VkComputePipelineCreateInfo computePipelineCreateInfo = makeComputePipelineCreateInfo(vkModule, pipelineLayout,
+        specializationInfo);
+
+    VkPipeline pipeline;
+    if (vkCreateComputePipelines(device, pipelineCache, 1, &computePipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create compute pipeline!");
+    }
+
+    pipelines.emplace(std::move(key), pipeline);
+
+    return pipeline;
+}
+
+JobManager::PipelineKey JobManager::makePipelineKey(VkShaderModule vkModule, VkPipelineLayout pipelineLayout,
+    const VkSpecializationInfo *specializationInfo)
+{
+    // specialization constants are compared by their map entries and data
+    std::vector<char> specialization;
+    if (specializationInfo != nullptr)
+    {
+        const char *entries = reinterpret_cast<const char*>(specializationInfo->pMapEntries);
+        const char *data = static_cast<const char*>(specializationInfo->pData);
+        specialization.insert(specialization.end(), entries,
+            entries + specializationInfo->mapEntryCount * sizeof(VkSpecializationMapEntry));
+        specialization.insert(specialization.end(), data, data + specializationInfo->dataSize);
+    }
+
+    return std::make_tuple(vkModule, pipelineLayout, std::move(specialization));
+}
+
+VkComputePipelineCreateInfo JobManager::makeComputePipelineCreateInfo(VkShaderModule vkModule,
+    VkPipelineLayout pipelineLayout, const VkSpecializationInfo *specializationInfo)
 {
     VkPipelineShaderStageCreateInfo shaderStage = {};
     shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -568,43 +1444,169 @@ VkPipeline JobManager::createComputePipeline(VkShaderModule vkModule, VkPipeline
 
     VkComputePipelineCreateInfo computePipelineCreateInfo{};
     computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-    // computePipelineCreateInfo.flags;
+    // ranges larger than the workgroup count limit are split into dispatches with base offsets
+    computePipelineCreateInfo.flags = VK_PIPELINE_CREATE_DISPATCH_BASE_BIT;
     computePipelineCreateInfo.stage = shaderStage;
     computePipelineCreateInfo.layout = pipelineLayout;
 
-    VkPipeline pipeline;
-    if (vkCreateComputePipelines(device, nullptr, 1, &computePipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS)
-    {
-        throw std::runtime_error("Failed to create compute pipeline!");
-    }
-
-    return pipeline;
+    return computePipelineCreateInfo;
 }
 
 void JobManager::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer,
     AllocatedMemory& bufferMemory, VkMemoryPropertyFlags optionalProperties)
 {
+    checkMemorySoftLimit(size);
+
+    // staging buffers are never accessed by the shaders, so they do not need addresses
+    if (bufferDeviceAddressSupported && (usage & (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)))
+        usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // buffers may be copied on the transfer queue and used on the compute queue within
+    // the same job, so they are shared instead of transferring ownership back and forth
+    uint32_t queueFamilies[] = { queueFamilyIndices.computeFamily.value(), queueFamilyIndices.transferFamily.value() };
+    if (hasDedicatedTransferQueue())
+    {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = 2;
+        bufferInfo.pQueueFamilyIndices = queueFamilies;
+    }
+
     bufferMemory = allocator->createBuffer(buffer, bufferInfo, properties, optionalProperties);
+
+    // host-visible memory stays mapped until the buffer is destroyed
+    if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        if (allocator->mapMemory(bufferMemory, size, &bufferMemory.mappedData) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to map buffer memory!");
+        }
+    }
+}
+
+VkDeviceSize JobManager::getUsedMemory()
+{
+    VkDeviceSize used = 0;
+    for (const auto &heap : allocator->getHeapStatistics())
+        used += heap.usedBytes;
+    return used;
+}
+
+void JobManager::checkMemorySoftLimit(VkDeviceSize size)
+{
+    if (settings.memorySoftLimit == 0 || getUsedMemory() + size <= settings.memorySoftLimit)
+        return;
+
+    // evict resources whose last references are held by destroyed jobs that are still executed
+    std::vector<VkFence> fences;
+    for (const auto &objects : pendingJobObjects)
+    {
+        if (objects.resources.empty())
+            continue;
+        fences.push_back(objects.fence);
+        if (objects.batchFence)
+            fences.push_back(*objects.batchFence);
+    }
+    if (fences.size() > 0)
+    {
+        if (vkWaitForFences(device, static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to wait for fence!");
+        }
+        reclaimJobObjects();
+    }
+
+    if (getUsedMemory() + size > settings.memorySoftLimit)
+    {
+        throw std::runtime_error("Memory soft limit exceeded");
+    }
 }
 
-VkImageView JobManager::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
+ResourceLifetime JobManager::registerResource(const ResourceObjects &objects)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    size_t key = nextResourceKey++;
+    resourceObjects.emplace(key, objects);
+
+    std::weak_ptr<JobManager *> owner = resourceOwner;
+    return ResourceLifetime(new size_t(key), [owner](size_t *key) {
+        if (auto manager = owner.lock())
+            (*manager)->destroyResource(*key);
+        delete key;
+    });
+}
+
+void JobManager::destroyResource(size_t key)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    auto it = resourceObjects.find(key);
+    if (it == resourceObjects.end())
+        return;
+
+    // cached sets referring to the resource would be returned for new objects with the same handle
+    uint64_t handle = it->second.buffer != VK_NULL_HANDLE ? (uint64_t)it->second.buffer : (uint64_t)it->second.imageView;
+    for (auto cached = descriptorSetCache.begin(); cached != descriptorSetCache.end();)
+    {
+        const auto &handles = cached->first.second;
+        if (std::find(handles.begin(), handles.end(), handle) != handles.end())
+        {
+            // jobs that used the set are done, since they held the resource
+            cachedDescriptorAllocator.free(cached->second);
+            cached = descriptorSetCache.erase(cached);
+        }
+        else
+            ++cached;
+    }
+
+    destroyResourceObjects(it->second);
+    resourceObjects.erase(it);
+}
+
+void JobManager::destroyResourceObjects(const ResourceObjects &objects)
+{
+    if (objects.imageView != VK_NULL_HANDLE)
+        vkDestroyImageView(device, objects.imageView, nullptr);
+    if (objects.storageImageView != VK_NULL_HANDLE)
+        vkDestroyImageView(device, objects.storageImageView, nullptr);
+    for (const auto& [key, view]: objects.bufferViews)
+        vkDestroyBufferView(device, view, nullptr);
+    if (objects.image != VK_NULL_HANDLE)
+        vkDestroyImage(device, objects.image, nullptr);
+    if (objects.buffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(device, objects.buffer, nullptr);
+    if (objects.stagingBuffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(device, objects.stagingBuffer, nullptr);
+
+    for (const auto &memory : { objects.memory, objects.stagingMemory })
+    {
+        if (memory.memory == VK_NULL_HANDLE && memory.customData == nullptr)
+            continue;
+        if (memory.mappedData != nullptr)
+            allocator->unmapMemory(memory);
+        allocator->freeMemory(memory);
+    }
+}
+
+VkImageView JobManager::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
+    uint32_t mipLevels, uint32_t arrayLayers)
 {
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = image;
-    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.viewType = arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = arrayLayers;
 
     VkImageView imageView;
     if (vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS)
@@ -616,7 +1618,7 @@ VkImageView JobManager::createImageView(VkImage image, VkFormat format, VkImageA
 }
 
 void JobManager::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-    VkMemoryPropertyFlags properties, VkImage& image, AllocatedMemory& imageMemory)
+    VkMemoryPropertyFlags properties, VkImage& image, AllocatedMemory& imageMemory, uint32_t mipLevels, uint32_t arrayLayers)
 {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -624,8 +1626,8 @@ void JobManager::createImage(uint32_t width, uint32_t height, VkFormat format, V
     imageInfo.extent.width = width;
     imageInfo.extent.height = height;
     imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
-    imageInfo.arrayLayers = 1;
+    imageInfo.mipLevels = mipLevels;
+    imageInfo.arrayLayers = arrayLayers;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
     imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -636,10 +1638,11 @@ void JobManager::createImage(uint32_t width, uint32_t height, VkFormat format, V
     imageMemory = allocator->createImage(image, imageInfo, properties, 0);
 }
 
-void JobManager::transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout)
+VkImageMemoryBarrier2 JobManager::makeImageLayoutBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+    uint32_t mipLevels, uint32_t arrayLayers)
 {
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    VkImageMemoryBarrier2 barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
     barrier.oldLayout = oldLayout;
     barrier.newLayout = newLayout;
     barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -647,27 +1650,24 @@ void JobManager::transitionImageLayout(VkCommandBuffer commandBuffer, VkImage im
     barrier.image = image;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.levelCount = mipLevels;
     barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
+    barrier.subresourceRange.layerCount = arrayLayers;
 
     switch (oldLayout)
     {
     case VK_IMAGE_LAYOUT_UNDEFINED:
         barrier.srcAccessMask = 0;
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT;
         break;
     case VK_IMAGE_LAYOUT_GENERAL:
-        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-        sourceStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT;
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
         break;
     case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
     case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
         break;
     default:
         throw std::invalid_argument("Unsupported layout transition!");
@@ -676,94 +1676,92 @@ void JobManager::transitionImageLayout(VkCommandBuffer commandBuffer, VkImage im
     switch (newLayout)
     {
     case VK_IMAGE_LAYOUT_GENERAL:
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
         break;
     case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
         break;
     case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
         break;
     case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
         barrier.dstAccessMask = 0;
-        destinationStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT;
         break;
     default:
         throw std::invalid_argument("Unsupported layout transition!");
     }
 
-    vkCmdPipelineBarrier(
-        commandBuffer,
-        sourceStage, destinationStage,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &barrier
-    );
-}
-
-void JobManager::copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, size_t width, size_t height)
-{
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {
-        static_cast<uint32_t>(width),
-        static_cast<uint32_t>(height),
-        1
-    };
+    return barrier;
+}
+
+std::vector<VkBufferImageCopy> JobManager::makeBufferImageCopies(const Image &image, size_t bufferOffset)
+{
+    std::vector<VkBufferImageCopy> regions(image.getMipLevels());
+    for (uint32_t level = 0; level < image.getMipLevels(); ++level)
+    {
+        VkBufferImageCopy &region = regions[level];
+        region.bufferOffset = bufferOffset + image.getMipLevelOffset(level);
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = image.getArrayLayers();
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {
+            static_cast<uint32_t>(image.getMipWidth(level)),
+            static_cast<uint32_t>(image.getMipHeight(level)),
+            1
+        };
+    }
 
-    vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    return regions;
 }
 
-void JobManager::copyImageToBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, size_t width, size_t height)
+void JobManager::copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, const Image &image, size_t bufferOffset)
 {
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.mipLevel = 0;
-    region.imageSubresource.baseArrayLayer = 0;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = {0, 0, 0};
-    region.imageExtent = {
-        static_cast<uint32_t>(width),
-        static_cast<uint32_t>(height),
-        1
-    };
+    auto regions = makeBufferImageCopies(image, bufferOffset);
 
-    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+    vkCmdCopyBufferToImage(commandBuffer, buffer, image.getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(regions.size()), regions.data());
 }
 
-void JobManager::copyImageToImage(VkCommandBuffer commandBuffer, VkImage src, VkImageLayout srcLayout, VkImage dst, VkImageLayout dstLayout,
-    size_t width, size_t height)
+void JobManager::copyImageToBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, const Image &image, size_t bufferOffset)
 {
-    VkImageSubresourceLayers layer{};
-    layer.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    layer.mipLevel = 0;
-    layer.baseArrayLayer = 0;
-    layer.layerCount = 1;
+    auto regions = makeBufferImageCopies(image, bufferOffset);
 
-    VkImageCopy region{};
-    region.srcSubresource = layer;
-    region.dstSubresource = layer;
-    region.extent = {
-        static_cast<uint32_t>(width),
-        static_cast<uint32_t>(height),
-        1
-    };
+    vkCmdCopyImageToBuffer(commandBuffer, image.getImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer,
+        static_cast<uint32_t>(regions.size()), regions.data());
+}
 
-    vkCmdCopyImage(commandBuffer, src, srcLayout, dst, dstLayout, 1, &region);
+void JobManager::copyImageToImage(VkCommandBuffer commandBuffer, const Image &src, const Image &dst)
+{
+    uint32_t mipLevels = std::min(src.getMipLevels(), dst.getMipLevels());
+    std::vector<VkImageCopy> regions(mipLevels);
+    for (uint32_t level = 0; level < mipLevels; ++level)
+    {
+        VkImageSubresourceLayers layer{};
+        layer.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        layer.mipLevel = level;
+        layer.baseArrayLayer = 0;
+        layer.layerCount = std::min(src.getArrayLayers(), dst.getArrayLayers());
+
+        VkImageCopy &region = regions[level];
+        region.srcSubresource = layer;
+        region.dstSubresource = layer;
+        region.extent = {
+            static_cast<uint32_t>(std::min(src.getMipWidth(level), dst.getMipWidth(level))),
+            static_cast<uint32_t>(std::min(src.getMipHeight(level), dst.getMipHeight(level))),
+            1
+        };
+    }
+
+    vkCmdCopyImage(commandBuffer, src.getImage(), src.getLayout(), dst.getImage(), dst.getLayout(),
+        static_cast<uint32_t>(regions.size()), regions.data());
 }
 
 void JobManager::copyBufferToBuffer(VkCommandBuffer commandBuffer, VkBuffer src, VkBuffer dst, size_t size,
@@ -774,22 +1772,58 @@ void JobManager::copyBufferToBuffer(VkCommandBuffer commandBuffer, VkBuffer src,
     vkCmdCopyBuffer(commandBuffer, src, dst, 1, &region);
 }
 
-void JobManager::copyDataToHostVisibleMemory(const void *data, size_t size, const AllocatedMemory& memory)
-{
+void JobManager::copyDataToHostVisibleMemory(const void *data, size_t size, const AllocatedMemory& memory, size_t offset)
+{
+    if (memory.mappedData != nullptr)
+    {
+        char *dst = static_cast<char*>(memory.mappedData) + offset;
+        // data might have been written directly into the mapped memory
+        if (dst != data)
+            memcpy(dst, data, size);
+        return;
+    }
+
     void* stagingData;
-    allocator->mapMemory(memory, size, &stagingData);
-        memcpy(stagingData, data, size);
+    allocator->mapMemory(memory, offset + size, &stagingData);
+        memcpy(static_cast<char*>(stagingData) + offset, data, size);
     allocator->unmapMemory(memory);
 }
 
-void JobManager::copyDataFromHostVisibleMemory(void *data, size_t size, const AllocatedMemory& memory)
+void JobManager::copyDataFromHostVisibleMemory(void *data, size_t size, const AllocatedMemory& memory, size_t offset)
 {
+    if (memory.mappedData != nullptr)
+    {
+        const char *src = static_cast<const char*>(memory.mappedData) + offset;
+        if (src != data)
+            memcpy(data, src, size);
+        return;
+    }
+
     void* stagingData;
-    allocator->mapMemory(memory, size, &stagingData);
-        memcpy(data, stagingData, size);
+    allocator->mapMemory(memory, offset + size, &stagingData);
+        memcpy(data, static_cast<char*>(stagingData) + offset, size);
     allocator->unmapMemory(memory);
 }
 
+StagingRingBuffer* JobManager::getStagingRingBuffer()
+{
+    if (!stagingRingBuffer)
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+        // image copies require offsets to be multiple of 4 and of the texel size
+        size_t alignment = std::max<size_t>({ 16,
+            static_cast<size_t>(properties.limits.optimalBufferCopyOffsetAlignment),
+            static_cast<size_t>(properties.limits.nonCoherentAtomSize) });
+
+        stagingRingBuffer = std::make_unique<StagingRingBuffer>(device,
+            createBuffer(settings.stagingBufferSize, Buffer::Type::Staging), alignment);
+    }
+
+    return stagingRingBuffer.get();
+}
+
 uint32_t JobManager::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags optionalProperties)
 {
     VkPhysicalDeviceMemoryProperties memProperties;
@@ -817,7 +1851,6 @@ uint32_t JobManager::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags p
 
 JobManager::QueueFamilyIndices JobManager::findQueueFamilies(VkPhysicalDevice device)
 {
-    // TODO dedicated transfer queue?
     QueueFamilyIndices indices;
 
     uint32_t queueFamilyCount = 0;
@@ -826,13 +1859,22 @@ JobManager::QueueFamilyIndices JobManager::findQueueFamilies(VkPhysicalDevice de
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
-    int i = 0;
+    uint32_t i = 0;
     for (const auto& queueFamily: queueFamilies)
     {
-        if (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT &&
+        if (!indices.computeFamily.has_value() &&
+            queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT &&
             queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT)
         {
             indices.computeFamily = i;
+        }
+
+        // transfer-only families usually map to the separate copy engines
+        if (settings.useDedicatedTransferQueue &&
+            !indices.transferFamily.has_value() &&
+            queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT &&
+            !(queueFamily.queueFlags & (VK_QUEUE_COMPUTE_BIT | VK_QUEUE_GRAPHICS_BIT)))
+        {
             indices.transferFamily = i;
         }
 
@@ -842,59 +1884,158 @@ JobManager::QueueFamilyIndices JobManager::findQueueFamilies(VkPhysicalDevice de
         i++;
     }
 
+    if (!indices.transferFamily.has_value())
+    {
+        indices.transferFamily = indices.computeFamily;
+    }
+
     return indices;
 }
 
-void JobManager::createCommandPool()
+void JobManager::createPipelineCache()
 {
-    QueueFamilyIndices queueFamilyIndices = findQueueFamilies(physicalDevice);
+    std::vector<char> data;
+    if (!settings.pipelineCachePath.empty() && std::ifstream(settings.pipelineCachePath).good())
+    {
+        data = readFile(settings.pipelineCachePath, true);
+        if (!isPipelineCacheCompatible(data))
+        {
+            data.clear();
+        }
+    }
 
-    VkCommandPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    // poolInfo.flags; // TODO
-    poolInfo.queueFamilyIndex = queueFamilyIndices.computeFamily.value();
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.data();
+
+    if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS)
+    {
+        // cached data might be corrupted, start with the empty cache
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = nullptr;
+        if (vkCreatePipelineCache(device, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to create pipeline cache!");
+        }
+    }
+}
+
+void JobManager::savePipelineCache()
+{
+    if (settings.pipelineCachePath.empty())
+        return;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+        return;
 
-    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device, pipelineCache, &size, data.data()) != VK_SUCCESS)
+        return;
+
+    // called from the destructor, so failure to save the cache is not an error
+    std::ofstream ofs(settings.pipelineCachePath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ofs.is_open())
     {
-        throw std::runtime_error("failed to create graphics command pool!");
+        std::cerr << "Failed to save pipeline cache to " << settings.pipelineCachePath << std::endl;
+        return;
     }
+    ofs.write(data.data(), size);
 }
 
-void JobManager::createDescriptorPool()
+bool JobManager::isPipelineCacheCompatible(const std::vector<char> &data)
 {
-    std::array<VkDescriptorPoolSize, 2> poolSizes{};
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    poolSizes[0].descriptorCount = 256;
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-    poolSizes[1].descriptorCount = 256;
+    // header layout is defined by VkPipelineCacheHeaderVersionOne
+    constexpr size_t headerSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+    if (data.size() < headerSize)
+        return false;
 
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-    poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = 256;
+    uint32_t header[4];
+    std::memcpy(header, data.data(), sizeof(header));
 
-    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS)
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    return header[0] >= headerSize &&
+        header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header[2] == properties.vendorID &&
+        header[3] == properties.deviceID &&
+        std::memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+VkCommandPool JobManager::createCommandPool(uint32_t queueFamilyIndex)
+{
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    // command buffers are reset together with the pool when jobs are reset or recycled
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+
+    VkCommandPool pool;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS)
     {
-        throw std::runtime_error("failed to create descriptor pool!");
+        throw std::runtime_error("failed to create command pool!");
     }
+
+    return pool;
+}
+
+void JobManager::createDescriptorAllocators()
+{
+    const std::vector<VkDescriptorType> types = {
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,
+        VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER
+    };
+
+    descriptorAllocator = DescriptorAllocator(types);
+    descriptorAllocator.initialize(device);
+    // sets of the destroyed resources are evicted from the cache one by one
+    cachedDescriptorAllocator = DescriptorAllocator(types, 256, true);
+    cachedDescriptorAllocator.initialize(device);
 }
 
 VkDescriptorSet JobManager::createDescriptorSet(std::vector<VkDescriptorType> types, const std::vector<Resource *> &resources,
-    VkDescriptorSetLayout descriptorSetLayout)
+    VkDescriptorSetLayout descriptorSetLayout, DescriptorAllocator &descriptorSetAllocator)
 {
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = descriptorPool;
-    allocInfo.descriptorSetCount = 1;
-    allocInfo.pSetLayouts = &descriptorSetLayout;
+    if (resources.size() != types.size())
+        throw std::runtime_error("Number of the bound resources does not match the number of the bindings");
 
-    VkDescriptorSet descriptorSet;
-    if (vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+    for (size_t i = 0; i < types.size(); ++i)
     {
-        throw std::runtime_error("failed to allocate descriptor sets!");
+        ResourceType resourceType = resources[i]->getResourceType();
+        bool imageDescriptor = types[i] == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ||
+            types[i] == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bool texelDescriptor = types[i] == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER ||
+            types[i] == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
+        if (imageDescriptor != isImageResource(resourceType) ||
+            (types[i] == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && resourceType != ResourceType::SampledImage) ||
+            (texelDescriptor && !isTexelBufferResource(resourceType)))
+        {
+            throw std::runtime_error("Resource can not be bound to the binding of type " + std::to_string(types[i]));
+        }
+
+        // ranges of the buffers are bound with their offsets (see BufferView)
+        if (types[i] == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER &&
+            static_cast<Buffer*>(resources[i])->getOffset() % computeLimits.minStorageBufferOffsetAlignment != 0)
+        {
+            throw std::runtime_error("Offset of the bound buffer is not a multiple of minStorageBufferOffsetAlignment");
+        }
+        if (types[i] == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER &&
+            static_cast<Buffer*>(resources[i])->getOffset() % computeLimits.minUniformBufferOffsetAlignment != 0)
+        {
+            throw std::runtime_error("Offset of the bound buffer is not a multiple of minUniformBufferOffsetAlignment");
+        }
     }
 
+    VkDescriptorSet descriptorSet = descriptorSetAllocator.allocate(descriptorSetLayout);
+
     std::vector<VkWriteDescriptorSet> descriptorWrites{};
     std::vector<std::function<void()>> deleters;
 
@@ -907,25 +2048,42 @@ VkDescriptorSet JobManager::createDescriptorSet(std::vector<VkDescriptorType> ty
         write.dstArrayElement = 0;
         write.descriptorCount = 1;
 
-        if (types[i] == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+        if (types[i] == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER || types[i] == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+            types[i] == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC || types[i] == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC)
         {
             VkDescriptorBufferInfo *bufferInfo = new VkDescriptorBufferInfo{};
-            bufferInfo->buffer = static_cast<Buffer*>(resources[i])->getBuffer();
-            bufferInfo->offset = 0;
-            bufferInfo->range = VK_WHOLE_SIZE;
+            const Buffer *buffer = static_cast<Buffer*>(resources[i]);
+            bufferInfo->buffer = buffer->getBuffer();
+            // offsets of the dynamic buffers are passed when the set is bound (see getDynamicOffsets())
+            bool dynamic = types[i] == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC ||
+                types[i] == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            bufferInfo->offset = dynamic ? 0 : buffer->getOffset();
+            bufferInfo->range = buffer->getSize();
             deleters.push_back([bufferInfo](){
                 delete bufferInfo;
             });
 
-            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write.descriptorType = types[i];
             write.pBufferInfo = bufferInfo;
             
             descriptorWrites.push_back(write);
         }
+        else if (types[i] == VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER || types[i] == VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER)
+        {
+            VkBufferView *bufferView = new VkBufferView(static_cast<TexelBufferView*>(resources[i])->getView());
+            deleters.push_back([bufferView](){
+                delete bufferView;
+            });
+
+            write.descriptorType = types[i];
+            write.pTexelBufferView = bufferView;
+
+            descriptorWrites.push_back(write);
+        }
         else if (types[i] == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
         {
             VkDescriptorImageInfo *imageInfo = new VkDescriptorImageInfo{};
-            imageInfo->imageView = static_cast<Image*>(resources[i])->getView();;
+            imageInfo->imageView = static_cast<Image*>(resources[i])->getStorageView();
             imageInfo->imageLayout = VK_IMAGE_LAYOUT_GENERAL;
             deleters.push_back([imageInfo](){
                 delete imageInfo;
@@ -934,6 +2092,23 @@ VkDescriptorSet JobManager::createDescriptorSet(std::vector<VkDescriptorType> ty
             write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
             write.pImageInfo = imageInfo;
 
+            descriptorWrites.push_back(write);
+        }
+        else if (types[i] == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+        {
+            // images stay in the general layout between transfers
+            VkDescriptorImageInfo *imageInfo = new VkDescriptorImageInfo{};
+            const SampledImage *image = static_cast<SampledImage*>(resources[i]);
+            imageInfo->sampler = image->getSampler();
+            imageInfo->imageView = image->getView();
+            imageInfo->imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+            deleters.push_back([imageInfo](){
+                delete imageInfo;
+            });
+
+            write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write.pImageInfo = imageInfo;
+
             descriptorWrites.push_back(write);
         }
     }
@@ -946,12 +2121,105 @@ VkDescriptorSet JobManager::createDescriptorSet(std::vector<VkDescriptorType> ty
     return descriptorSet;
 }
 
-VkCommandBuffer JobManager::createCommandBuffer()
+VkDescriptorSet JobManager::getCachedDescriptorSet(const std::vector<Resource *> &resources,
+    VkDescriptorSetLayout descriptorSetLayout, const std::vector<ResourceType> &types)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    std::vector<uint64_t> handles;
+    for (size_t i = 0; i < resources.size(); ++i)
+    {
+        const auto resource = resources[i];
+        if (isBufferResource(resource->getResourceType()))
+        {
+            handles.push_back((uint64_t)static_cast<Buffer*>(resource)->getBuffer());
+            // ranges of the same size share the set of the dynamic buffer
+            if (i >= types.size() || !isDynamicResource(types[i]))
+                handles.push_back(static_cast<Buffer*>(resource)->getOffset());
+            handles.push_back(static_cast<Buffer*>(resource)->getSize());
+            if (isTexelBufferResource(resource->getResourceType()))
+                handles.push_back((uint64_t)static_cast<TexelBufferView*>(resource)->getView());
+        }
+        else if (resource->getResourceType() == ResourceType::SampledImage)
+        {
+            handles.push_back((uint64_t)static_cast<SampledImage*>(resource)->getView());
+            handles.push_back((uint64_t)static_cast<SampledImage*>(resource)->getSampler());
+        }
+        else
+            handles.push_back((uint64_t)static_cast<Image*>(resource)->getView());
+    }
+
+    auto key = std::make_pair(descriptorSetLayout, std::move(handles));
+    auto it = descriptorSetCache.find(key);
+    if (it != descriptorSetCache.end())
+    {
+        return it->second;
+    }
+
+    VkDescriptorSet descriptorSet = createDescriptorSet(
+        types.empty() ? resourceToDescriptorType(resources) : resourceToDescriptorType(types), resources,
+        descriptorSetLayout, cachedDescriptorAllocator);
+    descriptorSetCache.emplace(std::move(key), descriptorSet);
+
+    return descriptorSet;
+}
+
+std::vector<uint32_t> JobManager::getDynamicOffsets(const std::vector<Resource *> &resources,
+    const std::vector<ResourceType> &types)
 {
+    std::vector<uint32_t> offsets;
+    for (size_t i = 0; i < types.size() && i < resources.size(); ++i)
+    {
+        if (!isDynamicResource(types[i]))
+            continue;
+
+        size_t offset = static_cast<Buffer*>(resources[i])->getOffset();
+        VkDeviceSize alignment = types[i] == ResourceType::UniformBufferDynamic
+            ? computeLimits.minUniformBufferOffsetAlignment
+            : computeLimits.minStorageBufferOffsetAlignment;
+        if (offset % alignment != 0)
+            throw std::runtime_error("Offset of the dynamic buffer is not a multiple of the required alignment");
+        offsets.push_back(static_cast<uint32_t>(offset));
+    }
+
+    return offsets;
+}
+
+Job::CommandPool JobManager::acquireCommandPool(bool transfer)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    auto &freePools = transfer ? freeTransferCommandPools : freeCommandPools;
+    if (freePools.size() > 0)
+    {
+        // recycled pools are already reset
+        Job::CommandPool pool = std::move(freePools.back());
+        freePools.pop_back();
+        return pool;
+    }
+
+    Job::CommandPool pool;
+    pool.pool = createCommandPool(transfer ? queueFamilyIndices.transferFamily.value() :
+        queueFamilyIndices.computeFamily.value());
+    commandPools.push_back(pool.pool);
+
+    return pool;
+}
+
+VkCommandBuffer JobManager::allocateCommandBuffer(Job::CommandPool &pool, VkCommandBufferLevel level)
+{
+    bool primary = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    auto &commandBuffers = primary ? pool.primaryCommandBuffers : pool.secondaryCommandBuffers;
+    auto &usedCount = primary ? pool.usedPrimaryCount : pool.usedSecondaryCount;
+    if (usedCount < commandBuffers.size())
+    {
+        return commandBuffers[usedCount++];
+    }
+
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = pool.pool;
+    allocInfo.level = level;
     allocInfo.commandBufferCount = 1;
 
     VkCommandBuffer commandBuffer;
@@ -960,9 +2228,218 @@ VkCommandBuffer JobManager::createCommandBuffer()
         throw std::runtime_error("Failed to allocate command buffer!");
     }
 
+    commandBuffers.push_back(commandBuffer);
+    ++usedCount;
+
     return commandBuffer;
 }
 
+void JobManager::resetCommandPool(Job::CommandPool &pool)
+{
+    if (vkResetCommandPool(device, pool.pool, 0) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to reset command pool!");
+    }
+    pool.usedPrimaryCount = 0;
+    pool.usedSecondaryCount = 0;
+}
+
+void JobManager::releaseCommandPools(std::vector<Job::CommandPool> &&pools)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    for (auto &pool : pools)
+    {
+        resetCommandPool(pool);
+        freeCommandPools.push_back(std::move(pool));
+    }
+}
+
+void JobManager::enqueueAsyncCompletion(AsyncCompletion &&completion)
+{
+    std::lock_guard<std::mutex> lock(completionMutex);
+
+    asyncCompletions.push_back(std::move(completion));
+    if (!completionThread.joinable())
+        completionThread = std::thread(&JobManager::runCompletionThread, this);
+    completionCondition.notify_one();
+}
+
+void JobManager::runCompletionThread()
+{
+    std::unique_lock<std::mutex> lock(completionMutex);
+    while (true)
+    {
+        completionCondition.wait(lock, [this]() { return exitCompletionThread || asyncCompletions.size() > 0; });
+        // pending jobs are completed before exiting
+        if (asyncCompletions.empty())
+            return;
+
+        std::vector<VkFence> fences;
+        for (const auto &completion : asyncCompletions)
+            fences.push_back(completion.job->getSubmissionFence());
+
+        lock.unlock();
+        VkResult res = vkWaitForFences(device, static_cast<uint32_t>(fences.size()), fences.data(), VK_FALSE,
+            completionPollInterval);
+        lock.lock();
+
+        std::vector<AsyncCompletion> completed;
+        for (size_t i = 0; i < asyncCompletions.size(); ++i)
+        {
+            if (res != VK_SUCCESS && res != VK_TIMEOUT)
+            {
+                asyncCompletions[i].callback = nullptr;
+                asyncCompletions[i].promise.set_exception(std::make_exception_ptr(
+                    std::runtime_error("Failed to wait for fence!")));
+            }
+            else if (vkGetFenceStatus(device, asyncCompletions[i].job->getSubmissionFence()) == VK_SUCCESS)
+            {
+                completed.push_back(std::move(asyncCompletions[i]));
+            }
+            else
+                continue;
+
+            asyncCompletions.erase(asyncCompletions.begin() + i);
+            --i;
+        }
+
+        // callbacks are called without the lock, so that they can submit new jobs
+        lock.unlock();
+        for (auto &completion : completed)
+        {
+            try
+            {
+                completion.job->await(0);
+                if (completion.callback)
+                    completion.callback(*completion.job);
+                // objects captured by the callback are released before the future is ready
+                completion.callback = nullptr;
+                completion.promise.set_value();
+            }
+            catch (...)
+            {
+                completion.callback = nullptr;
+                completion.promise.set_exception(std::current_exception());
+            }
+        }
+        lock.lock();
+    }
+}
+
+void JobManager::joinCompletionThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(completionMutex);
+        exitCompletionThread = true;
+        completionCondition.notify_one();
+    }
+
+    if (completionThread.joinable())
+        completionThread.join();
+}
+
+void JobManager::recycleJobObjects(RecycledJobObjects &&objects)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    pendingJobObjects.push_back(std::move(objects));
+}
+
+void JobManager::reclaimJobObjects()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    for (size_t i = 0; i < pendingJobObjects.size(); ++i)
+    {
+        auto &objects = pendingJobObjects[i];
+        // job is still executed by the device
+        if (vkGetFenceStatus(device, objects.fence) != VK_SUCCESS)
+            continue;
+        if (objects.batchFence && vkGetFenceStatus(device, *objects.batchFence) != VK_SUCCESS)
+            continue;
+
+        for (auto &pool : objects.commandPools)
+        {
+            resetCommandPool(pool);
+            freeCommandPools.push_back(std::move(pool));
+        }
+        for (auto &pool : objects.transferCommandPools)
+        {
+            resetCommandPool(pool);
+            freeTransferCommandPools.push_back(std::move(pool));
+        }
+        freeSemaphores.insert(freeSemaphores.end(), objects.semaphores.begin(), objects.semaphores.end());
+        freeTimelineSemaphores.insert(freeTimelineSemaphores.end(),
+            objects.timelineSemaphores.begin(), objects.timelineSemaphores.end());
+        freeQueryPools.insert(freeQueryPools.end(), objects.queryPools.begin(), objects.queryPools.end());
+        freeStatisticsQueryPools.insert(freeStatisticsQueryPools.end(),
+            objects.statisticsQueryPools.begin(), objects.statisticsQueryPools.end());
+
+        if (stagingRingBuffer)
+            stagingRingBuffer->release(objects.batchFence ? *objects.batchFence : objects.fence, objects.fence);
+
+        freeFences.push_back(objects.fence);
+
+        // shared fence is recycled on release, which must not happen while erasing
+        auto batchFence = std::move(objects.batchFence);
+        pendingJobObjects.erase(pendingJobObjects.begin() + i);
+        --i;
+    }
+}
+
+void JobManager::freeCommandBufferPools()
+{
+    // releasing shared fences of the batched submissions puts them back to the pending objects
+    while (pendingJobObjects.size() > 0)
+    {
+        std::vector<RecycledJobObjects> pending = std::move(pendingJobObjects);
+        pendingJobObjects.clear();
+    }
+
+    // pools of the jobs that are still alive are destroyed as well, together with their fences
+    for (auto pool : commandPools)
+        vkDestroyCommandPool(device, pool, nullptr);
+    commandPools.clear();
+    freeCommandPools.clear();
+    freeTransferCommandPools.clear();
+
+    // fences and semaphores are destroyed along with all the others
+    freeFences.clear();
+    freeSemaphores.clear();
+    freeTimelineSemaphores.clear();
+    freeQueryPools.clear();
+    freeStatisticsQueryPools.clear();
+}
+
+VkFence JobManager::acquireFence()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    if (freeFences.size() > 0)
+    {
+        // recycled fences are left in the signaled state
+        VkFence fence = freeFences.back();
+        freeFences.pop_back();
+        return fence;
+    }
+
+    VkFence fence = createFence();
+    fences.push_back(fence);
+
+    return fence;
+}
+
+std::shared_ptr<VkFence> JobManager::createSharedFence()
+{
+    // fence is returned to the pool once it is signaled and no job refers to it
+    uint64_t generation = resourceGeneration;
+    return std::shared_ptr<VkFence>(new VkFence(acquireFence()), [this, generation](VkFence *fence) {
+        if (generation == resourceGeneration)
+            recycleJobObjects({ *fence });
+        delete fence;
+    });
+}
+
 VkFence JobManager::createFence()
 {
     VkFenceCreateInfo fenceInfo{};
@@ -978,10 +2455,81 @@ VkFence JobManager::createFence()
     return fence;
 }
 
+VkQueryPool JobManager::createQueryPool(VkQueryType type)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    auto &freePools = type == VK_QUERY_TYPE_PIPELINE_STATISTICS ? freeStatisticsQueryPools : freeQueryPools;
+    if (freePools.size() > 0)
+    {
+        // queries are reset by the jobs right before they are written
+        VkQueryPool queryPool = freePools.back();
+        freePools.pop_back();
+        return queryPool;
+    }
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = type;
+    poolInfo.queryCount = queriesPerPool;
+    if (type == VK_QUERY_TYPE_PIPELINE_STATISTICS)
+        poolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+    VkQueryPool queryPool;
+    if (vkCreateQueryPool(device, &poolInfo, nullptr, &queryPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create query pool");
+    }
+
+    queryPools.push_back(queryPool);
+
+    return queryPool;
+}
+
 VkSemaphore JobManager::createSemaphore()
 {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    if (freeSemaphores.size() > 0)
+    {
+        VkSemaphore semaphore = freeSemaphores.back();
+        freeSemaphores.pop_back();
+        return semaphore;
+    }
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkSemaphore semaphore;
+    if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+    {
+        throw std::runtime_error("Failed to create semaphore");
+    }
+
+    semaphores.push_back(semaphore);
+
+    return semaphore;
+}
+
+VkSemaphore JobManager::createTimelineSemaphore()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    if (freeTimelineSemaphores.size() > 0)
+    {
+        VkSemaphore semaphore = freeTimelineSemaphores.back();
+        freeTimelineSemaphores.pop_back();
+        return semaphore;
+    }
+
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
 
     VkSemaphore semaphore;
     if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
@@ -1019,18 +2567,25 @@ JobManager::ShaderModule& JobManager::getShaderModule(const std::string& shaderP
     }
     else
     {
-        auto shaderCode = readFile(shaderPath, true);
-        ShaderModule shaderModule;
-        shaderModule.vkModule = createVkShaderModule(shaderCode);
-        shaderModule.reflectModule = std::make_shared<spv_reflect::ShaderModule>(shaderCode.size(), shaderCode.data());
-        reflectDescriptorSets(shaderModule.reflectModule.get(), shaderModule.layouts, shaderModule.resourceAccessFlags);
-        shaderModule.pushConstantSize = reflectPushConstantSize(shaderModule.reflectModule.get());
-
-        auto result = shaderModules.insert({ shaderPath, shaderModule });
+        auto result = shaderModules.insert({ shaderPath, loadShaderModule(shaderPath) });
         return result.first->second;
     }
 }
 
+JobManager::ShaderModule JobManager::loadShaderModule(const std::string& shaderPath)
+{
+    auto shaderCode = readFile(shaderPath, true);
+    ShaderModule shaderModule;
+    shaderModule.reflectModule = std::make_shared<spv_reflect::ShaderModule>(shaderCode.size(), shaderCode.data());
+    reflectDescriptorSets(shaderModule.reflectModule.get(), shaderModule.layouts, shaderModule.resourceAccessFlags);
+    shaderModule.pushConstantSize = reflectPushConstantSize(shaderModule.reflectModule.get());
+    reflectLocalSize(shaderModule.reflectModule.get(), shaderCode, shaderModule.localSize, shaderModule.localSizeSpecIds);
+    // created last, so that it is not leaked if reflection fails
+    shaderModule.vkModule = createVkShaderModule(shaderCode);
+
+    return shaderModule;
+}
+
 VkResult JobManager::CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
     const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger)
 {
@@ -1089,21 +2644,20 @@ std::vector<char> JobManager::readFile(const std::string &filename, bool binaryM
 
 Task JobManager::_createTask(const std::string &shaderPath, VkSpecializationInfo *specializationInfo)
 {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
     ShaderModule& shaderModule = getShaderModule(shaderPath);
 
     std::vector<VkDescriptorSetLayout> layouts;
     for (const auto &descriptorSetLayoutTypes: shaderModule.layouts)
     {
         layouts.push_back(createDescriptorSetLayout(descriptorSetLayoutTypes));
-        descriptorSetLayouts.push_back(layouts.back());
     }
     auto pipelineLayout = createPipelineLayout(layouts, static_cast<uint32_t>(shaderModule.pushConstantSize));
-    pipelineLayouts.push_back(pipelineLayout);
-
     auto pipeline = createComputePipeline(shaderModule.vkModule, pipelineLayout, specializationInfo);
-    pipelines.push_back(pipeline);
 
-    return { pipeline, pipelineLayout, layouts, shaderModule.resourceAccessFlags };
+    return { pipeline, pipelineLayout, layouts, shaderModule.resourceAccessFlags, getTaskName(shaderPath),
+        getLocalSize(shaderModule, specializationInfo), shaderModule.layouts };
 }
 
 ResourceType reflectDescriptorTypeToResourceType(SpvReflectDescriptorType type)
@@ -1114,6 +2668,18 @@ ResourceType reflectDescriptorTypeToResourceType(SpvReflectDescriptorType type)
             return ResourceType::StorageBuffer;
         case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_IMAGE:
             return ResourceType::StorageImage;
+        case SPV_REFLECT_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+            return ResourceType::SampledImage;
+        case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            return ResourceType::UniformBuffer;
+        case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+            return ResourceType::StorageBufferDynamic;
+        case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+            return ResourceType::UniformBufferDynamic;
+        case SPV_REFLECT_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+            return ResourceType::UniformTexelBuffer;
+        case SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            return ResourceType::StorageTexelBuffer;
         default:
             throw std::runtime_error("Unsupported descriptor type: " + std::to_string(type));
     }
@@ -1141,9 +2707,13 @@ void JobManager::reflectDescriptorSets(spv_reflect::ShaderModule* reflectModule,
         for (size_t j = 0; j < sets[i]->binding_count; ++j)
         {
             outLayout[i].push_back(reflectDescriptorTypeToResourceType(sets[i]->bindings[j]->descriptor_type));
+            // sampled images and uniform buffers can only be read
+            ResourceType type = outLayout[i].back();
+            bool readOnly = type == ResourceType::SampledImage || type == ResourceType::UniformBuffer ||
+                type == ResourceType::UniformBufferDynamic || type == ResourceType::UniformTexelBuffer;
             outResourceAccessFlags[i].push_back((sets[i]->bindings[j]->block.flags & SPV_REFLECT_VARIABLE_FLAGS_UNUSED)
                 ? AccessType::None
-                : ((sets[i]->bindings[j]->block.decoration_flags & SPV_REFLECT_DECORATION_NON_WRITABLE)
+                : ((sets[i]->bindings[j]->block.decoration_flags & SPV_REFLECT_DECORATION_NON_WRITABLE || readOnly)
                     ? AccessType::Read
                     : AccessType:: Read | AccessType::Write));
         }
@@ -1166,4 +2736,103 @@ uint32_t JobManager::reflectPushConstantSize(spv_reflect::ShaderModule* reflectM
     assert(result == SPV_REFLECT_RESULT_SUCCESS);
 
     return blocks[0]->size;
-}
\ No newline at end of file
+}
+
+void JobManager::reflectLocalSize(spv_reflect::ShaderModule* reflectModule, const std::vector<char>& code,
+    std::array<uint32_t, 3>& outLocalSize, std::array<std::optional<uint32_t>, 3>& outSpecIds)
+{
+    const auto &module = reflectModule->GetShaderModule();
+    if (module.entry_point_count > 0)
+    {
+        const auto &localSize = module.entry_points[0].local_size;
+        outLocalSize = { localSize.x, localSize.y, localSize.z };
+    }
+
+    // SPIRV-Reflect does not resolve sizes set with specialization constants (local_size_x_id),
+    // so the WorkgroupSize built-in and LocalSizeId execution mode are found in the code itself
+    constexpr uint32_t opExecutionMode = 16;
+    constexpr uint32_t opConstant = 43;
+    constexpr uint32_t opConstantComposite = 44;
+    constexpr uint32_t opSpecConstant = 50;
+    constexpr uint32_t opSpecConstantComposite = 51;
+    constexpr uint32_t opDecorate = 71;
+    constexpr uint32_t opExecutionModeId = 331;
+    constexpr uint32_t decorationSpecId = 1;
+    constexpr uint32_t decorationBuiltIn = 11;
+    constexpr uint32_t builtInWorkgroupSize = 25;
+    constexpr uint32_t executionModeLocalSize = 17;
+    constexpr uint32_t executionModeLocalSizeId = 38;
+
+    std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+    std::memcpy(words.data(), code.data(), words.size() * sizeof(uint32_t));
+
+    std::map<uint32_t, uint32_t> specIds;
+    std::map<uint32_t, uint32_t> constants;
+    std::map<uint32_t, std::vector<uint32_t>> composites;
+    std::optional<uint32_t> workgroupSizeId;
+    std::vector<uint32_t> localSizeIds;
+    // instructions start after the 5 words of the header
+    for (size_t i = 5; i < words.size();)
+    {
+        uint32_t wordCount = words[i] >> 16;
+        uint32_t opcode = words[i] & 0xFFFF;
+        if (wordCount == 0 || i + wordCount > words.size())
+            break;
+        const uint32_t *operands = words.data() + i + 1;
+
+        if (opcode == opDecorate && wordCount >= 4 && operands[1] == decorationSpecId)
+            specIds[operands[0]] = operands[2];
+        else if (opcode == opDecorate && wordCount >= 4 && operands[1] == decorationBuiltIn && operands[2] == builtInWorkgroupSize)
+            workgroupSizeId = operands[0];
+        else if ((opcode == opConstant || opcode == opSpecConstant) && wordCount >= 4)
+            constants[operands[1]] = operands[2];
+        else if ((opcode == opConstantComposite || opcode == opSpecConstantComposite) && wordCount >= 3)
+            composites[operands[1]] = std::vector<uint32_t>(operands + 2, operands + wordCount - 1);
+        else if (opcode == opExecutionModeId && wordCount >= 6 && operands[1] == executionModeLocalSizeId)
+            localSizeIds.assign(operands + 2, operands + 5);
+        else if (opcode == opExecutionMode && wordCount >= 6 && operands[1] == executionModeLocalSize)
+            outLocalSize = { operands[2], operands[3], operands[4] };
+
+        i += wordCount;
+    }
+
+    // the built-in takes precedence over the execution modes
+    if (workgroupSizeId.has_value() && composites.count(workgroupSizeId.value()) != 0)
+        localSizeIds = composites.at(workgroupSizeId.value());
+
+    for (size_t i = 0; i < 3 && i < localSizeIds.size(); ++i)
+    {
+        auto constant = constants.find(localSizeIds[i]);
+        if (constant != constants.end())
+            outLocalSize[i] = constant->second;
+        auto specId = specIds.find(localSizeIds[i]);
+        if (specId != specIds.end())
+            outSpecIds[i] = specId->second;
+    }
+}
+
+std::array<uint32_t, 3> JobManager::getLocalSize(const ShaderModule &shaderModule,
+    const VkSpecializationInfo *specializationInfo)
+{
+    std::array<uint32_t, 3> localSize = shaderModule.localSize;
+    if (specializationInfo == nullptr)
+        return localSize;
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        if (!shaderModule.localSizeSpecIds[i].has_value())
+            continue;
+
+        for (uint32_t j = 0; j < specializationInfo->mapEntryCount; ++j)
+        {
+            const auto &entry = specializationInfo->pMapEntries[j];
+            if (entry.constantID == shaderModule.localSizeSpecIds[i].value() && entry.size == sizeof(uint32_t))
+            {
+                std::memcpy(&localSize[i], static_cast<const char*>(specializationInfo->pData) + entry.offset,
+                    sizeof(uint32_t));
+            }
+        }
+    }
+
+    return localSize;
+}
@@ -5,6 +5,7 @@
 
 #include "Job.h"
 #include "Resources.h"
+#include "DescriptorAllocator.h"
 
 #include <stdexcept>
 #include <vector>
@@ -14,10 +15,19 @@
 #include <optional>
 #include <set>
 #include <functional>
+#include <memory>
+#include <map>
+#include <tuple>
+#include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <future>
 
 #define USE_VMA
 
 class DeviceMemoryAllocator;
+class StagingRingBuffer;
 
 namespace spv_reflect
 {
@@ -81,6 +91,163 @@ struct DeviceComputeLimits
      * @brief Maximum size of a local compute workgroup, per dimension
      */
     uint32_t maxComputeWorkGroupSize[3];
+    /**
+     * @brief Required alignment, in bytes, of the offsets of storage buffers bound to
+     * descriptor sets
+     */
+    VkDeviceSize minStorageBufferOffsetAlignment;
+    /**
+     * @brief Required alignment, in bytes, of the offsets of uniform buffers bound to
+     * descriptor sets
+     */
+    VkDeviceSize minUniformBufferOffsetAlignment;
+    /**
+     * @brief Required alignment, in bytes, of the offsets of texel buffers
+     * (see JobManager::createTexelBufferView())
+     */
+    VkDeviceSize minTexelBufferOffsetAlignment;
+    /**
+     * @brief Number of invocations in a subgroup of the compute shaders
+     */
+    uint32_t subgroupSize;
+    /**
+     * @brief Subgroup operations supported in the compute shaders, 0 if the compute stage
+     * does not support subgroup operations
+     */
+    VkSubgroupFeatureFlags subgroupOperations;
+};
+
+
+/**
+ * @brief Description of a single task created with JobManager::createTasks().
+ * 
+ */
+struct TaskCreateInfo
+{
+    std::string shaderPath;
+    std::vector<VkSpecializationMapEntry> specializationMapEntries;
+    std::vector<char> specializationData;
+    // name of the task (see Task::getName()), file name of the shader if empty
+    std::string name;
+    // (set, binding) pairs of the uniform and storage buffers that are bound as dynamic
+    // buffers, so that ranges of one buffer share a descriptor set (see Job::useResources())
+    std::vector<std::pair<uint32_t, uint32_t>> dynamicBindings;
+
+    /**
+     * @brief Describe task without specialization constants.
+     * 
+     * @param shaderPath Path to the already compiled SPIR-V shader
+     */
+    TaskCreateInfo(const std::string &shaderPath) :
+        shaderPath(shaderPath)
+    {}
+
+    /**
+     * @brief Describe task with specialization constants.
+     * 
+     * @tparam Args Typenames of the specialized constants
+     * @param shaderPath Path to the already compiled SPIR-V shader
+     * @param specializationConstants Specialization constants to be used in the shader
+     */
+    template<typename... Args>
+    TaskCreateInfo(const std::string &shaderPath, Args&&... specializationConstants) :
+        shaderPath(shaderPath),
+        specializationMapEntries(sizeof...(Args)),
+        specializationData(argsSize<Args...>())
+    {
+        copyArgs<Args...>(specializationData.data(), specializationMapEntries.data(), 0, 0,
+            std::forward<Args>(specializationConstants)...);
+    }
+};
+
+
+/**
+ * @brief Optional settings that change the way JobManager sets up the device.
+ * 
+ */
+struct JobManagerSettings
+{
+    /**
+     * @brief Use separate transfer-only queue family (if the device exposes one) for
+     * the copies between device-local buffers and their staging buffers, so that
+     * they can overlap with the compute work. See Job::syncResourceToDevice() and
+     * Job::syncResourceToHost() for details.
+     */
+    bool useDedicatedTransferQueue = false;
+
+    /**
+     * @brief Index of the physical device used by the manager among all suitable devices,
+     * which are ordered by their score: discrete GPUs first, then by the size of the
+     * device-local memory. 0 picks the best device. Ignored if the manager does not create
+     * Vulkan instance itself. See JobManager::getSuitableDeviceCount().
+     */
+    size_t deviceIndex = 0;
+
+    /**
+     * @brief Size (in bytes) of the staging buffer shared by all transfers between host
+     * and device-local resources. When set to 0, every DeviceLocal buffer and every image
+     * gets its own staging buffer of the same size. Otherwise resources are created without
+     * staging buffers and each transfer uses part of the shared buffer, which caps the amount
+     * of host-visible memory spent on staging regardless of the number of resources.
+     * Single job can not transfer more data than the size of the shared buffer.
+     */
+    size_t stagingBufferSize = 0;
+
+    /**
+     * @brief Path to the file with pipeline cache data. If not empty, cache is loaded
+     * from this file when the manager is created and saved back when it is destroyed,
+     * which speeds up task creation on the following runs. Cache created by another
+     * device or driver is ignored.
+     */
+    std::string pipelineCachePath;
+
+    /**
+     * @brief Minimal size (in bytes) of the device-local blocks into which transient
+     * buffers of a job are placed (see Job::createTransientBuffer()). Larger buffers
+     * get blocks of their own size.
+     */
+    size_t transientBlockSize = 16 * 1024 * 1024;
+
+    /**
+     * @brief Soft limit (in bytes) on the memory of all heaps occupied by the buffers and
+     * images of the manager. When non-zero, creation of a resource that would exceed it
+     * first releases resources kept alive by destroyed jobs and, if that is not enough,
+     * throws instead of letting the driver run out of memory. 0 means no limit.
+     */
+    size_t memorySoftLimit = 0;
+
+    /**
+     * @brief Measure GPU time of the tasks and transfers recorded into the main command
+     * buffer of the jobs with timestamp queries. Results are available after the job is
+     * awaited, see Job::getProfilingResults(). Ignored if the compute queue does not
+     * support timestamps.
+     */
+    bool enableProfiling = false;
+
+    /**
+     * @brief Collect the number of compute shader invocations of every task together with
+     * the profiling results (see ProfilingRecord::invocations). Ignored if the device does
+     * not support pipeline statistics queries.
+     */
+    bool enablePipelineStatistics = false;
+
+    /**
+     * @brief Enable VK_EXT_debug_utils (if available) and record command buffer labels
+     * around the dispatches and barriers of the jobs, so that captures made with tools
+     * like RenderDoc or Nsight show names of the tasks. Labels are recorded only by the
+     * manager that creates Vulkan instance itself.
+     */
+    bool enableDebugLabels = false;
+
+    /**
+     * @brief Enable buffer device addresses (VK_KHR_buffer_device_address), so that shaders
+     * can access any number of buffers through the 64-bit addresses passed in push constants
+     * or in other buffers, without binding them to descriptor sets (see
+     * Buffer::getDeviceAddress() and Job::useBufferAddresses()). Ignored if the device does
+     * not support it, the manager does not create the logical device itself or the memory
+     * allocator does not support it (see DeviceMemoryAllocator::supportsBufferDeviceAddress()).
+     */
+    bool enableBufferDeviceAddress = false;
 };
 
 
@@ -90,6 +257,9 @@ struct DeviceComputeLimits
  * Can be initialized either to create its own Vulkan resources or make use of already
  * created instance/logical device, which may be used for integration with already
  * existing pipeline.
+ * 
+ * Creation of the jobs, tasks and resources as well as submission of the jobs is
+ * thread-safe, so that jobs can be recorded and submitted from several threads.
  */
 class JobManager
 {
@@ -108,12 +278,15 @@ private:
 
     struct ShaderModule
     {
-        VkShaderModule vkModule;
+        VkShaderModule vkModule = VK_NULL_HANDLE;
         std::shared_ptr<spv_reflect::ShaderModule> reflectModule;
 
         std::vector<std::vector<ResourceType>> layouts;
         std::vector<std::vector<AccessTypeFlags>> resourceAccessFlags;
         size_t pushConstantSize = 0;
+        // components with specialization constant ids are overridden by the tasks
+        std::array<uint32_t, 3> localSize = { 1, 1, 1 };
+        std::array<std::optional<uint32_t>, 3> localSizeSpecIds;
     };
 
     VkInstance instance = VK_NULL_HANDLE;
@@ -121,27 +294,124 @@ private:
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     VkDevice device = VK_NULL_HANDLE;
     VkQueue computeQueue;
-    VkCommandPool commandPool;
-    VkDescriptorPool descriptorPool;
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    QueueFamilyIndices queueFamilyIndices;
+    // guards objects shared by the jobs; recursive, since public functions call each other
+    std::recursive_mutex mutex;
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    // descriptor sets of ResourceSets and sets created for raw resource bindings
+    DescriptorAllocator descriptorAllocator;
+    DescriptorAllocator cachedDescriptorAllocator;
+    std::map<std::pair<VkDescriptorSetLayout, std::vector<uint64_t>>, VkDescriptorSet> descriptorSetCache;
+    std::map<std::pair<VkFilter, VkSamplerAddressMode>, VkSampler> samplers;
     bool manageInstance;
-
-    std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
-    std::vector<VkPipelineLayout> pipelineLayouts;
-    std::vector<VkPipeline> pipelines;
+    JobManagerSettings settings;
+    bool timelineSemaphoresSupported = false;
+    bool memoryBudgetSupported = false;
+    bool bufferDeviceAddressSupported = false;
+    bool synchronization2Supported = false;
+    // loaded only if VK_KHR_synchronization2 is enabled
+    PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2 = nullptr;
+    bool deviceMappedMemorySupported = false;
+
+    // created objects are shared between all tasks and resource sets with the same
+    // description (binding types, set layouts, shader and specialization constants)
+    std::map<std::vector<VkDescriptorType>, VkDescriptorSetLayout> descriptorSetLayouts;
+    std::map<std::pair<std::vector<VkDescriptorSetLayout>, uint32_t>, VkPipelineLayout> pipelineLayouts;
+    using PipelineKey = std::tuple<VkShaderModule, VkPipelineLayout, std::vector<char>>;
+    std::map<PipelineKey, VkPipeline> pipelines;
 
     std::map<std::string, ShaderModule> shaderModules;
 
     DeviceMemoryAllocator* allocator = nullptr;
-    // allocated resources
-    std::vector<VkBuffer> buffers;
-    std::vector<struct AllocatedMemory> allocatedMemory;
-    std::vector<VkImage> images;
-    std::vector<VkImageView> imageViews;
+    // device objects of a single buffer or image, including its own staging buffer
+    struct ResourceObjects
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView imageView = VK_NULL_HANDLE;
+        VkImageView storageImageView = VK_NULL_HANDLE;
+        // texel buffer views of the buffer by their format, offset and size
+        std::map<std::tuple<VkFormat, size_t, size_t>, VkBufferView> bufferViews;
+        AllocatedMemory memory;
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        AllocatedMemory stagingMemory;
+    };
+
+    // allocated resources that are still referenced by handles or jobs
+    std::map<size_t, ResourceObjects> resourceObjects;
+    size_t nextResourceKey = 0;
+    // replaced by cleanupResources(), so that handles of already destroyed resources
+    // do nothing when released
+    std::shared_ptr<JobManager *> resourceOwner = std::make_shared<JobManager *>(this);
 
     std::vector<VkFence> fences;
+    std::vector<VkCommandPool> commandPools;
     std::vector<VkSemaphore> semaphores;
+    std::vector<VkQueryPool> queryPools;
+
+    // timestamp queries of the jobs are allocated from pools of this size
+    static constexpr uint32_t queriesPerPool = 64;
+    bool timestampsSupported = false;
+    float timestampPeriod = 1.0f;
+    uint64_t timestampMask = ~0ull;
+    bool pipelineStatisticsSupported = false;
+
+    // loaded only if debug labels are enabled
+    PFN_vkCmdBeginDebugUtilsLabelEXT cmdBeginDebugUtilsLabel = nullptr;
+    PFN_vkCmdEndDebugUtilsLabelEXT cmdEndDebugUtilsLabel = nullptr;
+
+    // objects of the destroyed job that may be still in use by the device
+    struct RecycledJobObjects
+    {
+        VkFence fence;
+        std::vector<Job::CommandPool> commandPools;
+        std::vector<Job::CommandPool> transferCommandPools;
+        std::vector<VkSemaphore> semaphores;
+        std::vector<VkSemaphore> timelineSemaphores;
+        std::vector<VkQueryPool> queryPools;
+        std::vector<VkQueryPool> statisticsQueryPools;
+        // fence of the batched submission, which has to be signaled as well
+        std::shared_ptr<VkFence> batchFence;
+        // resources used by the job, released once the job is done
+        std::set<ResourceLifetime> resources;
+    };
+
+    // pools of objects that can be reused by new jobs
+    std::vector<RecycledJobObjects> pendingJobObjects;
+    std::vector<VkFence> freeFences;
+    std::vector<Job::CommandPool> freeCommandPools;
+    std::vector<Job::CommandPool> freeTransferCommandPools;
+    std::vector<VkSemaphore> freeSemaphores;
+    std::vector<VkSemaphore> freeTimelineSemaphores;
+    std::vector<VkQueryPool> freeQueryPools;
+    std::vector<VkQueryPool> freeStatisticsQueryPools;
+    // incremented by cleanupResources(), so that jobs created before it do not return
+    // already destroyed objects to the pools
+    uint64_t resourceGeneration = 0;
+
+    // job submitted with Job::submitAsync() that is waited by the completion thread
+    struct AsyncCompletion
+    {
+        Job *job;
+        std::function<void(Job &)> callback;
+        std::promise<void> promise;
+    };
+    std::vector<AsyncCompletion> asyncCompletions;
+    std::mutex completionMutex;
+    std::condition_variable completionCondition;
+    // started by the first asynchronous submission, joined by the destructor
+    std::thread completionThread;
+    bool exitCompletionThread = false;
+    // completion thread waits for the fences at most this long (in nanoseconds), so that
+    // it notices jobs submitted in the meantime
+    static constexpr uint64_t completionPollInterval = 1000000;
+
+    // shared staging buffer, created on first use if settings.stagingBufferSize is set
+    std::unique_ptr<StagingRingBuffer> stagingRingBuffer;
 
     DeviceComputeLimits computeLimits;
+    size_t suitableDeviceCount = 1;
 
     const std::vector<const char*> validationLayers = {
         "VK_LAYER_KHRONOS_validation"
@@ -167,8 +437,12 @@ public:
      * creates all needed GPU-side resources.
      * 
      * @param extensions List of the device extensions that should be ebanbled
+     * @param memoryAllocator Allocator used for all device memory allocations or
+     * nullptr to use the default one
+     * @param settings Additional settings of the manager
      */
-    JobManager(const std::vector<std::string> extensions = {}, DeviceMemoryAllocator* memoryAllocator = nullptr);
+    JobManager(const std::vector<std::string> extensions = {}, DeviceMemoryAllocator* memoryAllocator = nullptr,
+        const JobManagerSettings& settings = {});
 
     /**
      * @brief Construct a new Job Manager object
@@ -191,7 +465,8 @@ public:
     /**
      * @brief Create a Task object
      * 
-     * Create Task using provided shader.
+     * Create Task using provided shader. Tasks created from the same shader share
+     * single pipeline.
      * 
      * @param shaderPath Path to the already compiled SPIR-V shader
      * @return Created Task
@@ -202,7 +477,8 @@ public:
      * @brief Create a Task object
      * 
      * Create Task using provided shader. Additionally makes use of provided
-     * specialization constants.
+     * specialization constants. Tasks created from the same shader with the same
+     * specialization constants share single pipeline.
      * 
      * @tparam Args Typenames of the specialized constants
      * @param shaderPath Path to the already compiled SPIR-V shader
@@ -226,12 +502,39 @@ public:
         return _createTask(shaderPath, &specializationInfo);
     }
 
+    /**
+     * @brief Create multiple Task objects at once.
+     * 
+     * Shader modules are loaded and reflected in parallel, and all new pipelines are
+     * created with batched calls spread over multiple threads, which is considerably
+     * faster than creating the same tasks one by one with createTask().
+     * 
+     * @param taskInfos Descriptions of the tasks
+     * @return Created tasks in the same order as \p taskInfos
+     */
+    std::vector<Task> createTasks(const std::vector<TaskCreateInfo> &taskInfos);
+
     /**
      * @brief Create a Buffer object
      * 
      * Memory type used by the buffer depends on its type. For every buffer
      * with DeviceLocal \p type additional staging buffer of the same size will be
-     * allocated and used during the transfer operations to/from host.
+     * allocated and used during the transfer operations to/from host, unless
+     * JobManagerSettings::stagingBufferSize is set. Host-visible
+     * memory (of Staging, Uniform, DeviceMapped and staging buffers) is mapped for the whole
+     * lifetime of the buffer, see Buffer::data().
+     * 
+     * DeviceMapped buffers are placed in the device-local memory that the host can write
+     * directly, so their transfers are plain copies on the host without any staging buffer
+     * or GPU copy commands. If the device has no such memory (see
+     * supportsDeviceMappedBuffers()), DeviceLocal buffer is created instead. Host reads of
+     * this memory are usually uncached and slow, so it fits data uploaded by the host
+     * better than results read back.
+     * 
+     * Copies of the returned Buffer share its device objects, which are destroyed when
+     * the last copy is gone and all jobs that recorded the buffer are either reset or
+     * destroyed, so the release never waits for the device. The Buffer object passed
+     * to the job's transfer functions still has to stay alive until the job is awaited.
      * 
      * @param size Size of the buffer in bytes
      * @param type Type of the buffer
@@ -242,9 +545,8 @@ public:
     /**
      * @brief Create an Image object
      * 
-     * Created storage image has 4 channels and is allocated in the device-local memory.
-     * Initial layout is undefined, so call to Job::syncResourceToDevice() may be needed
-     * to change image layout before using it in the shader.
+     * Created storage image has 4 channels and is allocated in the device-local memory
+     * (same as createImage(const ImageCreateInfo&) with the default format).
      * 
      * @param width Width of the image (in pixels)
      * @param height Height of the image (in pixels)
@@ -252,6 +554,39 @@ public:
      */
     Image createImage(size_t width, size_t height);
 
+    /**
+     * @brief Create an Image object with the given format, mip levels and array layers
+     * 
+     * Image is allocated in the device-local memory and can be used as a storage image
+     * and/or sampled (see createSampledImage()), depending on what the device supports
+     * for the format. Staging buffer of the size of all mip levels and layers is created
+     * for the image, unless JobManagerSettings::stagingBufferSize is set.
+     * Initial layout is undefined, so call to Job::syncResourceToDevice() may be needed
+     * to change image layout before using it in the shader.
+     * 
+     * Device objects of the image are released in the same way as the ones of buffers
+     * (see createBuffer()).
+     * 
+     * @param info Size, format, number of mip levels and array layers of the image
+     * @return Created Image
+     */
+    Image createImage(const ImageCreateInfo &info);
+
+    /**
+     * @brief Create a SampledImage object for the image
+     * 
+     * Sampled image refers to the same device image and is bound as a combined image
+     * sampler. Samplers are shared by all images with the same parameters and are
+     * destroyed together with the manager.
+     * 
+     * @param image Image created by this manager with a format that can be sampled
+     * @param filter Filter used for magnification, minification and between mip levels
+     * @param addressMode Addressing of the coordinates outside of the image
+     * @return Created SampledImage
+     */
+    SampledImage createSampledImage(const Image &image, VkFilter filter = VK_FILTER_LINEAR,
+        VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+
     /**
      * @brief Create a Resource Set object
      * 
@@ -265,11 +600,44 @@ public:
      */
     ResourceSet createResourceSet(const std::vector<Resource *> &resources);
 
+    /**
+     * @brief Create a Resource Set object for the descriptor set of the task
+     * 
+     * Same as createResourceSet(const std::vector<Resource *>&), except that resources
+     * are written with the types of the bindings declared in the shader (see
+     * Task::getResourceTypes()), e.g. buffers can be bound as uniform or dynamic buffers.
+     * Offsets of the dynamic buffers are stored in the set and passed when it is bound.
+     * 
+     * @param task Task whose descriptor set layout is used
+     * @param set Index of the descriptor set in the task
+     * @param resources List of resources
+     * @return Created ResourceSet
+     */
+    ResourceSet createResourceSet(const Task &task, size_t set, const std::vector<Resource *> &resources);
+
+    /**
+     * @brief Create a view of the buffer that is bound to the shaders as a texel buffer
+     * 
+     * Views of the same range with the same format are shared and destroyed together with
+     * the buffer.
+     * 
+     * @param buffer Buffer created by this manager or a range of it, has to start at
+     * a multiple of DeviceComputeLimits::minTexelBufferOffsetAlignment
+     * @param format Format of the texels
+     * @return Created TexelBufferView
+     */
+    TexelBufferView createTexelBufferView(const Buffer &buffer, VkFormat format);
+
     /**
      * @brief Create a Job object
      * 
-     * Either creates new command buffer or makes use of one passed as a parameter
-     * to create a Job object.
+     * Either takes command buffer from the pool or makes use of one passed as a parameter
+     * to create a Job object. Command buffers and fences of destroyed jobs are
+     * returned to the pool and reused by the new jobs once the device is done with them.
+     * 
+     * Jobs can be created and recorded from different threads. Layouts of the images are
+     * changed during the recording, so the same image must not be used by the jobs that
+     * are recorded at the same time.
      * 
      * @param commandBuffer Already existing command buffer or nullptr to create
      * a new one
@@ -277,6 +645,49 @@ public:
      */
     Job createJob(VkCommandBuffer commandBuffer = VK_NULL_HANDLE);
 
+    /**
+     * @brief Create a Job object that records a part of another job.
+     * 
+     * Commands are recorded into a secondary command buffer from the own pool of the job,
+     * so parts of a single job can be recorded by several threads and merged afterwards
+     * with Job::executeSecondaryJobs(). Secondary job can not be submitted and does not
+     * take part in profiling, its transfers can not use the shared staging buffer.
+     * 
+     * Secondary job can not transition layouts of the images, so all images it uses have
+     * to be in VK_IMAGE_LAYOUT_GENERAL already (e.g. after Job::syncResourceToDevice() of
+     * the primary job) and it can not transfer the images to or from the host or between
+     * each other, which throws.
+     * 
+     * @return Created Job
+     */
+    Job createSecondaryJob();
+
+    /**
+     * @brief Submit multiple jobs at once.
+     * 
+     * Command buffers of all jobs are submitted with a single vkQueueSubmit call per queue
+     * (or up to three calls if the dedicated transfer queue is used), which reduces the
+     * driver overhead of submitting many small jobs. Pending host to device transfers are
+     * completed for all jobs before the submission.
+     * 
+     * Jobs of a single submission share a fence, so isComplete() and await() of each job
+     * return only when all jobs of the submission are done (only those that end on the same
+     * queue, if the dedicated transfer queue is used). Use Job::wait() to wait for specific
+     * job when timeline semaphores are supported. Jobs are still awaited individually to
+     * complete their device to host transfers.
+     * 
+     * Dependencies between jobs of the same submission are allowed (see Job::dependsOn()),
+     * as long as the dependency precedes the dependent job in \p jobs. Transfers of the
+     * jobs through the shared staging buffer must not overlap.
+     * 
+     * Whole batch is validated first and none of its jobs is submitted if any of them can
+     * not be, the jobs stay in the recorded state.
+     * 
+     * @param jobs Distinct primary jobs created by this manager, none of which is in the
+     * submitted state
+     */
+    void submit(const std::vector<Job *> &jobs);
+
     /**
      * @brief Get the Device object
      * 
@@ -301,6 +712,123 @@ public:
      */
     DeviceComputeLimits getComputeLimits();
 
+    /**
+     * @brief Get the number of physical devices that could be used by the managers.
+     * 
+     * Valid values of JobManagerSettings::deviceIndex are below this number.
+     * 
+     * @return Number of suitable devices, 1 if the manager was created for an existing
+     * logical device
+     */
+    size_t getSuitableDeviceCount() const;
+
+    /**
+     * @brief Get properties of the physical device used by the manager.
+     * 
+     * @return VkPhysicalDeviceProperties
+     */
+    VkPhysicalDeviceProperties getDeviceProperties() const;
+
+    /**
+     * @brief Check whether transfers are executed on the dedicated transfer queue.
+     * 
+     * @return True if JobManagerSettings::useDedicatedTransferQueue was requested and
+     * device has a transfer-only queue family, false otherwise
+     */
+    bool hasDedicatedTransferQueue() const;
+
+    /**
+     * @brief Check whether timeline semaphores can be used for dependencies between jobs
+     * (see Job::dependsOn()).
+     * 
+     * @return True if the device supports Vulkan 1.2 timeline semaphores and the manager
+     * created the logical device itself, false otherwise
+     */
+    bool supportsTimelineSemaphores() const;
+
+    /**
+     * @brief Check whether VK_EXT_memory_budget is enabled, so that memory statistics
+     * report the real usage and budget of the heaps.
+     * 
+     * @return True if the device supports the extension and the manager created the
+     * logical device itself, false otherwise
+     */
+    bool supportsMemoryBudget() const;
+
+    /**
+     * @brief Check whether buffers of the manager have device addresses
+     * (see JobManagerSettings::enableBufferDeviceAddress).
+     */
+    bool supportsBufferDeviceAddress() const;
+
+    /**
+     * @brief Check whether VK_KHR_synchronization2 is enabled, so that barriers batched
+     * by the jobs keep individual stage masks of every resource.
+     * 
+     * @return True if the device supports the extension and the manager created the
+     * logical device itself, false otherwise
+     */
+    bool supportsSynchronization2() const;
+
+    /**
+     * @brief Check whether Buffer::Type::DeviceMapped buffers are backed by host-visible
+     * device-local memory.
+     * 
+     * @return True if the device exposes such memory in a heap larger than the legacy
+     * 256 MiB BAR window (resizable BAR or integrated GPU), false otherwise
+     */
+    bool supportsDeviceMappedBuffers() const;
+
+    /**
+     * @brief Check whether GPU times of the operations are measured by the jobs (see
+     * JobManagerSettings::enableProfiling).
+     * 
+     * @return True if profiling is enabled and the compute queue supports timestamps
+     */
+    bool isProfilingEnabled() const;
+
+    /**
+     * @brief Check whether compute shader invocations of the tasks are counted by the jobs
+     * (see JobManagerSettings::enablePipelineStatistics).
+     * 
+     * @return True if pipeline statistics are enabled and supported by the device
+     */
+    bool isPipelineStatisticsEnabled() const;
+
+    /**
+     * @brief Check whether jobs record debug labels (see JobManagerSettings::enableDebugLabels).
+     * 
+     * @return True if debug labels are enabled and VK_EXT_debug_utils is available
+     */
+    bool areDebugLabelsEnabled() const;
+
+    /**
+     * @brief Get memory usage and budget of every memory heap of the device as reported
+     * by the device memory allocator.
+     * 
+     * @return std::vector<MemoryHeapStatistics> Statistics indexed by memory heap index
+     */
+    std::vector<MemoryHeapStatistics> getMemoryStatistics();
+
+    /**
+     * @brief Free descriptor sets created for the resources bound to the tasks directly
+     * (i.e. not through ResourceSet).
+     * 
+     * Such sets are cached and reused when the same resources are bound to a task with
+     * the same layout. Jobs recorded before this call must be reset (see Job::reset())
+     * or destroyed before they are submitted again.
+     * 
+     */
+    void clearDescriptorSetCache();
+
+    /**
+     * @brief Get number of the descriptor pools that hold the cached descriptor sets.
+     * 
+     * Sets of the destroyed resources are freed, so the count grows only with the number
+     * of the cached sets that are alive at the same time.
+     */
+    size_t getCachedDescriptorPoolCount() const;
+
     /**
      * @brief Cleanup allocated resources.
      * 
@@ -320,15 +848,25 @@ private:
     bool checkValidationLayerSupport();
     std::vector<const char*> getRequiredExtensions();
     void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
+    bool checkInstanceExtensionSupport(const char *extensionName);
+    void loadDebugLabelFunctions();
     void setupDebugMessenger();
 
     void pickPhysicalDevice();
     void createLogicalDevice();
 
     bool isDeviceSuitable(VkPhysicalDevice device);
+    // higher score is better: discrete GPUs first, then by the size of the device-local memory
+    static uint64_t getDeviceScore(VkPhysicalDevice device);
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
 
     void cacheComputeLimits();
+    void cacheMemoryProperties();
+    void cacheTimestampProperties();
+
+    void createPipelineCache();
+    void savePipelineCache();
+    bool isPipelineCacheCompatible(const std::vector<char> &data);
 
     VkDescriptorSetLayout createDescriptorSetLayout(std::vector<VkDescriptorType> types);
     VkDescriptorSetLayout createDescriptorSetLayout(std::vector<ResourceType> types);
@@ -337,42 +875,88 @@ private:
         uint32_t pushConstantSize);
     VkPipeline createComputePipeline(VkShaderModule vkModule, VkPipelineLayout pipelineLayout,
         VkSpecializationInfo *specializationInfo);
+    static PipelineKey makePipelineKey(VkShaderModule vkModule, VkPipelineLayout pipelineLayout,
+        const VkSpecializationInfo *specializationInfo);
+    static VkComputePipelineCreateInfo makeComputePipelineCreateInfo(VkShaderModule vkModule,
+        VkPipelineLayout pipelineLayout, const VkSpecializationInfo *specializationInfo);
 
     void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer,
         AllocatedMemory& bufferMemory, VkMemoryPropertyFlags optionalProperties = 0);
 
-    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-    void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-        VkMemoryPropertyFlags properties, VkImage& image, AllocatedMemory& imageMemory);
-
-    void transitionImageLayout(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
+    VkDeviceSize getUsedMemory();
+    void checkMemorySoftLimit(VkDeviceSize size);
 
-    void copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, size_t width, size_t height);
-    void copyImageToBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, size_t width, size_t height);
-    void copyImageToImage(VkCommandBuffer commandBuffer, VkImage src, VkImageLayout srcLayout, VkImage dst, VkImageLayout dstLayout,
-        size_t width, size_t height);
+    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags,
+        uint32_t mipLevels = 1, uint32_t arrayLayers = 1);
+    Buffer allocateBuffer(size_t size, Buffer::Type type, bool withStagingBuffer);
+    ResourceLifetime registerResource(const ResourceObjects &objects);
+    void destroyResource(size_t key);
+    void destroyResourceObjects(const ResourceObjects &objects);
+    void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
+        VkMemoryPropertyFlags properties, VkImage& image, AllocatedMemory& imageMemory,
+        uint32_t mipLevels = 1, uint32_t arrayLayers = 1);
+    VkSampler getSampler(VkFilter filter, VkSamplerAddressMode addressMode);
+
+    // stage and access masks are limited to the ones that have the same values in
+    // synchronization2 and in the original barriers
+    static VkImageMemoryBarrier2 makeImageLayoutBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout,
+        uint32_t mipLevels = 1, uint32_t arrayLayers = 1);
+
+    // one region per mip level, laid out in the buffer as described by Image
+    static std::vector<VkBufferImageCopy> makeBufferImageCopies(const Image &image, size_t bufferOffset);
+    void copyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, const Image &image, size_t bufferOffset = 0);
+    void copyImageToBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, const Image &image, size_t bufferOffset = 0);
+    // mip levels and layers present in both images, each cropped to the smaller extent
+    void copyImageToImage(VkCommandBuffer commandBuffer, const Image &src, const Image &dst);
     void copyBufferToBuffer(VkCommandBuffer commandBuffer, VkBuffer src, VkBuffer dst, size_t size,
         size_t srcOffset = 0, size_t dstOffset = 0);
 
-    void copyDataToHostVisibleMemory(const void *data, size_t size, const AllocatedMemory& memory);
-    void copyDataFromHostVisibleMemory(void *data, size_t size, const AllocatedMemory& memory);
+    void copyDataToHostVisibleMemory(const void *data, size_t size, const AllocatedMemory& memory, size_t offset = 0);
+    void copyDataFromHostVisibleMemory(void *data, size_t size, const AllocatedMemory& memory, size_t offset = 0);
+
+    StagingRingBuffer* getStagingRingBuffer();
 
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags optionalProperties = 0);
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
 
-    void createCommandPool();
-    void createDescriptorPool();
+    VkCommandPool createCommandPool(uint32_t queueFamilyIndex);
+    void createDescriptorAllocators();
 
     VkDescriptorSet createDescriptorSet(std::vector<VkDescriptorType> types, const std::vector<Resource *> &resources,
-        VkDescriptorSetLayout descriptorSetLayout);
-    VkCommandBuffer createCommandBuffer();
-
+        VkDescriptorSetLayout descriptorSetLayout, DescriptorAllocator &descriptorSetAllocator);
+    // descriptor types are the ones of the task bindings, if known, otherwise the ones of the resources
+    VkDescriptorSet getCachedDescriptorSet(const std::vector<Resource *> &resources,
+        VkDescriptorSetLayout descriptorSetLayout, const std::vector<ResourceType> &types = {});
+    // offsets of the dynamic buffers passed when the set is bound
+    std::vector<uint32_t> getDynamicOffsets(const std::vector<Resource *> &resources,
+        const std::vector<ResourceType> &types);
+    Job::CommandPool acquireCommandPool(bool transfer);
+    VkCommandBuffer allocateCommandBuffer(Job::CommandPool &pool, VkCommandBufferLevel level);
+    void resetCommandPool(Job::CommandPool &pool);
+    // returns pools of the compute queue family that are not used by the device
+    void releaseCommandPools(std::vector<Job::CommandPool> &&pools);
+
+    void enqueueAsyncCompletion(AsyncCompletion &&completion);
+    void runCompletionThread();
+    void joinCompletionThread();
+
+    // startedQueue executes the parts of the cancelled jobs that were already submitted
+    void cancelBatch(const std::vector<Job *> &jobs, std::shared_ptr<VkFence> &fence, VkQueue startedQueue);
+    void recycleJobObjects(RecycledJobObjects &&objects);
+    void reclaimJobObjects();
+    void freeCommandBufferPools();
+
+    VkFence acquireFence();
+    VkQueryPool createQueryPool(VkQueryType type);
+    std::shared_ptr<VkFence> createSharedFence();
     VkFence createFence();
     VkSemaphore createSemaphore();
+    VkSemaphore createTimelineSemaphore();
 
     VkShaderModule createVkShaderModule(const std::vector<char>& code);
 
     ShaderModule& getShaderModule(const std::string& shaderPath);
+    ShaderModule loadShaderModule(const std::string& shaderPath);
 
     static VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
         const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger);
@@ -390,6 +974,10 @@ private:
         std::vector<std::vector<ResourceType>>& outLayout,
         std::vector<std::vector<AccessTypeFlags>>& outResourceAccessFlags);
     uint32_t reflectPushConstantSize(spv_reflect::ShaderModule* reflectModule);
+    void reflectLocalSize(spv_reflect::ShaderModule* reflectModule, const std::vector<char>& code,
+        std::array<uint32_t, 3>& outLocalSize, std::array<std::optional<uint32_t>, 3>& outSpecIds);
+    static std::array<uint32_t, 3> getLocalSize(const ShaderModule &shaderModule,
+        const VkSpecializationInfo *specializationInfo);
 };
 
 #endif // JOB_MANAGER_H
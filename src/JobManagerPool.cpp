@@ -0,0 +1,139 @@
+#include "JobManagerPool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+JobManagerPool::JobManagerPool(const std::vector<std::string> extensions, const JobManagerSettings &settings,
+    size_t maxDeviceCount)
+{
+    if (maxDeviceCount == 0)
+    {
+        throw std::runtime_error("Pool needs at least one device");
+    }
+
+    // the first manager finds out how many devices there are
+    JobManagerSettings deviceSettings = settings;
+    deviceSettings.deviceIndex = 0;
+    managers.push_back(std::make_unique<JobManager>(extensions, nullptr, deviceSettings));
+
+    size_t deviceCount = std::min(maxDeviceCount, managers[0]->getSuitableDeviceCount());
+    for (size_t i = 1; i < deviceCount; ++i)
+    {
+        deviceSettings.deviceIndex = i;
+        // caches of different devices are not compatible
+        if (!settings.pipelineCachePath.empty())
+            deviceSettings.pipelineCachePath = settings.pipelineCachePath + "." + std::to_string(i);
+        managers.push_back(std::make_unique<JobManager>(extensions, nullptr, deviceSettings));
+    }
+
+    pendingJobCounts.resize(managers.size(), 0);
+}
+
+size_t JobManagerPool::getManagerCount() const
+{
+    return managers.size();
+}
+
+JobManager& JobManagerPool::getManager(size_t index)
+{
+    return *managers.at(index);
+}
+
+JobManager& JobManagerPool::pickManager(DistributionPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t index = 0;
+    switch (policy)
+    {
+    case DistributionPolicy::RoundRobin:
+        index = nextManager;
+        nextManager = (nextManager + 1) % managers.size();
+        break;
+    case DistributionPolicy::LeastLoaded:
+        index = std::min_element(pendingJobCounts.begin(), pendingJobCounts.end()) - pendingJobCounts.begin();
+        break;
+    }
+
+    return *managers[index];
+}
+
+std::future<void> JobManagerPool::submitAsync(Job &job, std::function<void(Job &)> callback)
+{
+    auto it = std::find_if(managers.begin(), managers.end(), [&job](const std::unique_ptr<JobManager> &manager) {
+        return manager.get() == job.getManager();
+    });
+    if (it == managers.end())
+    {
+        throw std::runtime_error("Job was not created by the managers of the pool");
+    }
+    size_t index = it - managers.begin();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++pendingJobCounts[index];
+    }
+
+    // released together with the callback, also if the job fails to be submitted or completed
+    std::shared_ptr<void> pending(nullptr, [this, index](void *) {
+        std::lock_guard<std::mutex> lock(mutex);
+        --pendingJobCounts[index];
+    });
+
+    return job.submitAsync([pending, callback = std::move(callback)](Job &completed) {
+        if (callback)
+            callback(completed);
+    });
+}
+
+void JobManagerPool::dispatchRange(size_t count, const RangeRecorder &record, size_t granularity)
+{
+    if (granularity == 0)
+    {
+        throw std::runtime_error("Granularity of the range has to be positive");
+    }
+
+    size_t groupCount = (count + granularity - 1) / granularity;
+
+    // reserved, so that submitted jobs are never moved
+    std::vector<Job> jobs;
+    jobs.reserve(managers.size());
+    std::vector<std::future<void>> futures;
+
+    // jobs that were already submitted are awaited before any error is rethrown
+    std::exception_ptr error;
+    try
+    {
+        for (size_t i = 0; i < managers.size(); ++i)
+        {
+            size_t first = std::min(count, groupCount * i / managers.size() * granularity);
+            size_t last = std::min(count, groupCount * (i + 1) / managers.size() * granularity);
+            if (first == last)
+                continue;
+
+            jobs.push_back(managers[i]->createJob());
+            record(*managers[i], jobs.back(), first, last - first);
+            futures.push_back(submitAsync(jobs.back()));
+        }
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    for (auto &future : futures)
+    {
+        try
+        {
+            future.get();
+        }
+        catch (...)
+        {
+            if (!error)
+                error = std::current_exception();
+        }
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
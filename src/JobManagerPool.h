@@ -0,0 +1,119 @@
+#ifndef JOB_MANAGER_POOL_H
+#define JOB_MANAGER_POOL_H
+
+#include "JobManager.h"
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <string>
+
+/**
+ * @brief Policy of JobManagerPool::pickManager().
+ */
+enum class DistributionPolicy
+{
+    // managers are picked in turns
+    RoundRobin,
+    // manager with the least number of jobs that were submitted through the pool and are
+    // not complete yet, the one with the better device if there are several
+    LeastLoaded
+};
+
+/**
+ * @brief Set of JobManagers, one per suitable physical device.
+ *
+ * Managers are ordered by the score of their devices, i.e. the same way as
+ * JobManagerSettings::deviceIndex. Every job and resource belongs to a single manager,
+ * so the manager is picked before the job is recorded and the job is submitted through
+ * the pool, which keeps track of the load of the devices.
+ */
+class JobManagerPool
+{
+public:
+    /**
+     * @brief Function that records part of the range dispatch into the job.
+     *
+     * Receives manager of the device, job created by it, first index of the part and the
+     * number of indices in the part. Resources used by the job have to be created by the
+     * same manager.
+     */
+    using RangeRecorder = std::function<void(JobManager &manager, Job &job, size_t first, size_t count)>;
+
+private:
+    // declared before the managers, since their completion threads use them until joined
+    std::mutex mutex;
+    std::vector<size_t> pendingJobCounts;
+    size_t nextManager = 0;
+
+    std::vector<std::unique_ptr<JobManager>> managers;
+
+public:
+    /**
+     * @brief Create a manager for every suitable physical device.
+     *
+     * @param extensions List of the device extensions that should be enabled by all managers
+     * @param settings Settings of all managers, JobManagerSettings::deviceIndex is ignored;
+     * pipeline caches of the devices other than the best one are stored in the files with
+     * the device index appended to JobManagerSettings::pipelineCachePath
+     * @param maxDeviceCount Maximal number of devices to use, the best ones are used
+     */
+    JobManagerPool(const std::vector<std::string> extensions = {}, const JobManagerSettings &settings = {},
+        size_t maxDeviceCount = SIZE_MAX);
+
+    JobManagerPool(const JobManagerPool&) = delete;
+    JobManagerPool& operator=(const JobManagerPool&) = delete;
+
+    /**
+     * @brief Get the number of managers in the pool.
+     */
+    size_t getManagerCount() const;
+
+    /**
+     * @brief Get manager of the device.
+     *
+     * @param index Index of the manager, 0 is the manager of the best device
+     * @return JobManager
+     */
+    JobManager& getManager(size_t index);
+
+    /**
+     * @brief Pick the manager that should record the next job.
+     *
+     * @param policy How the work is distributed between the devices
+     * @return JobManager
+     */
+    JobManager& pickManager(DistributionPolicy policy = DistributionPolicy::RoundRobin);
+
+    /**
+     * @brief Submit job created by one of the managers of the pool.
+     *
+     * Same as Job::submitAsync(), additionally counts the job as the load of its device
+     * until it is complete (see DistributionPolicy::LeastLoaded).
+     *
+     * @param job Job created by one of the managers of the pool
+     * @param callback Function called on the completion thread after the job is complete
+     * @return Future that is ready after the job is complete and the callback returned
+     */
+    std::future<void> submitAsync(Job &job, std::function<void(Job &)> callback = {});
+
+    /**
+     * @brief Split range of indices between all devices and wait until every part is done.
+     *
+     * Range is divided into one contiguous part per device of nearly equal size. Every part is
+     * recorded by \p record into the job of the corresponding manager, which usually
+     * uploads the input of the part, dispatches tasks over it (see Job::addTaskRange()) and
+     * reads results back into the part of the host memory. Jobs of all devices are executed
+     * concurrently and results are gathered once this function returns.
+     *
+     * @param count Number of indices in the range
+     * @param record Function that records a single part
+     * @param granularity Sizes of all parts except for the last one are multiples of this
+     * value, e.g. of the local size of the task
+     */
+    void dispatchRange(size_t count, const RangeRecorder &record, size_t granularity = 1);
+};
+
+#endif // JOB_MANAGER_POOL_H
@@ -0,0 +1,268 @@
+#include "Primitives.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // upper bound of the workgroup size, larger workgroups only add barrier steps
+    constexpr uint32_t maxWorkgroupSize = 256;
+    // elements summed or counted by every invocation before the workgroup is synchronized
+    constexpr uint32_t itemsPerReduceInvocation = 8;
+    constexpr uint32_t radixBits = 4;
+    constexpr uint32_t radix = 1u << radixBits;
+
+    // push constants of the shaders
+    struct CountParams
+    {
+        uint32_t count;
+    };
+
+    struct FillParams
+    {
+        uint32_t count;
+        uint32_t value;
+    };
+
+    struct ScanParams
+    {
+        uint32_t count;
+        uint32_t asFlags;
+    };
+
+    struct RadixParams
+    {
+        uint32_t count;
+        uint32_t shift;
+        uint32_t groupCount;
+    };
+
+    uint32_t floorPowerOfTwo(uint32_t value)
+    {
+        uint32_t result = 1;
+        while (result <= value / 2)
+            result *= 2;
+
+        return result;
+    }
+
+    void checkSize(const Buffer &buffer, uint32_t count, const std::string &name)
+    {
+        if (buffer.getSize() < static_cast<size_t>(count) * sizeof(uint32_t))
+            throw std::runtime_error(name + " buffer is smaller than the number of elements");
+    }
+}
+
+Primitives::Primitives(JobManager &manager, const std::string &shaderDirectory) :
+    manager(manager),
+    shaderDirectory(shaderDirectory),
+    itemsPerInvocation(itemsPerReduceInvocation)
+{
+    auto limits = manager.getComputeLimits();
+    // scratch of the workgroup has to fit into the shared memory together with a histogram
+    // of the same size
+    uint32_t maxSize = std::min({ maxWorkgroupSize, limits.maxComputeWorkGroupSize[0],
+        limits.maxComputeWorkGroupInvocations, limits.maxComputeSharedMemorySize / (2 * static_cast<uint32_t>(sizeof(uint32_t))) });
+    workgroupSize = floorPowerOfTwo(maxSize);
+
+    // ballots find the active invocations of the subgroups, which do not have to be full
+    constexpr VkSubgroupFeatureFlags requiredOperations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT |
+        VK_SUBGROUP_FEATURE_BALLOT_BIT;
+    uint32_t subgroupSize = limits.subgroupSize;
+    if ((limits.subgroupOperations & requiredOperations) == requiredOperations && subgroupSize >= 4 &&
+        (subgroupSize & (subgroupSize - 1)) == 0 && subgroupSize <= workgroupSize)
+    {
+        shaderSuffix = "_subgroup";
+    }
+
+    const char *shaderNames[KernelCount] = {
+        "primitives_fill",
+        "primitives_reduce",
+        "primitives_scan",
+        "primitives_scan_add",
+        "primitives_compact",
+        "primitives_radix_count",
+        "primitives_radix_scatter"
+    };
+    std::vector<TaskCreateInfo> infos;
+    for (const char *name : shaderNames)
+        infos.emplace_back(getShaderPath(name), workgroupSize, itemsPerInvocation);
+    tasks = manager.createTasks(infos);
+}
+
+uint32_t Primitives::getWorkgroupSize() const
+{
+    return workgroupSize;
+}
+
+bool Primitives::usesSubgroups() const
+{
+    return !shaderSuffix.empty();
+}
+
+Job& Primitives::reduce(Job &job, Buffer &input, Buffer &output, uint32_t count)
+{
+    checkSize(input, count, "Input");
+    checkSize(output, 1, "Output");
+
+    Buffer source = input;
+    Buffer result(output, 0, sizeof(uint32_t));
+    std::vector<Buffer> partials;
+    uint32_t remaining = count;
+    while (true)
+    {
+        uint32_t groups = getGroupCount(remaining, itemsPerInvocation);
+        Buffer destination = groups == 1 ? result : job.createTransientBuffer(groups * sizeof(uint32_t));
+        job.pushConstants(CountParams{ remaining })
+            .addTaskRange(tasks[Reduce], { { &source, &destination } }, groups * workgroupSize);
+        if (groups == 1)
+            break;
+
+        partials.push_back(destination);
+        source = destination;
+        remaining = groups;
+    }
+
+    for (const auto &partial : partials)
+        job.releaseTransientBuffer(partial);
+
+    return job;
+}
+
+Job& Primitives::exclusiveScan(Job &job, Buffer &input, Buffer &output, uint32_t count)
+{
+    checkSize(input, count, "Input");
+    checkSize(output, count, "Output");
+
+    if (count > 0)
+        scan(job, input, output, count, false);
+
+    return job;
+}
+
+Job& Primitives::sort(Job &job, Buffer &keys, uint32_t count)
+{
+    checkSize(keys, count, "Keys");
+    if (count <= 1)
+        return job;
+
+    uint32_t groups = getGroupCount(count, 1);
+    uint32_t countsSize = radix * groups;
+    Buffer sorted = job.createTransientBuffer(count * sizeof(uint32_t));
+    Buffer counts = job.createTransientBuffer(countsSize * sizeof(uint32_t));
+    Buffer offsets = job.createTransientBuffer(countsSize * sizeof(uint32_t));
+
+    // even number of passes leaves the result in the keys
+    Buffer *source = &keys;
+    Buffer *destination = &sorted;
+    for (uint32_t shift = 0; shift < 32; shift += radixBits)
+    {
+        RadixParams params{ count, shift, groups };
+        job.pushConstants(params)
+            .addTaskRange(tasks[RadixCount], { { source, &counts } }, count);
+        scan(job, counts, offsets, countsSize, false);
+        job.pushConstants(params)
+            .addTaskRange(tasks[RadixScatter], { { source, &offsets, destination } }, count);
+        std::swap(source, destination);
+    }
+
+    job.releaseTransientBuffer(offsets);
+    job.releaseTransientBuffer(counts);
+    job.releaseTransientBuffer(sorted);
+
+    return job;
+}
+
+Job& Primitives::compact(Job &job, Buffer &input, Buffer &flags, Buffer &output, Buffer &outputCount, uint32_t count)
+{
+    checkSize(input, count, "Input");
+    checkSize(flags, count, "Flags");
+    checkSize(outputCount, 1, "Output count");
+
+    Buffer countRange(outputCount, 0, sizeof(uint32_t));
+    if (count == 0)
+    {
+        fill(job, countRange, 1, 0);
+        return job;
+    }
+
+    Buffer offsets = job.createTransientBuffer(count * sizeof(uint32_t));
+    scan(job, flags, offsets, count, true);
+    job.pushConstants(CountParams{ count })
+        .addTaskRange(tasks[Compact], { { &input, &flags, &offsets, &output, &countRange } }, count);
+    job.releaseTransientBuffer(offsets);
+
+    return job;
+}
+
+Job& Primitives::histogram(Job &job, Buffer &input, Buffer &bins, uint32_t count, uint32_t binCount)
+{
+    checkSize(input, count, "Input");
+    checkSize(bins, binCount, "Bins");
+    if (binCount == 0)
+        throw std::runtime_error("Histogram must have at least one bin");
+
+    const Task &task = getHistogramTask(binCount);
+    Buffer binRange(bins, 0, binCount * sizeof(uint32_t));
+    fill(job, binRange, binCount, 0);
+    if (count > 0)
+    {
+        job.pushConstants(CountParams{ count })
+            .addTaskRange(task, { { &input, &binRange } }, getGroupCount(count, itemsPerInvocation) * workgroupSize);
+    }
+
+    return job;
+}
+
+std::string Primitives::getShaderPath(const std::string &name) const
+{
+    return shaderDirectory + "/" + name + shaderSuffix + ".spv";
+}
+
+uint32_t Primitives::getGroupCount(uint32_t count, uint32_t itemsPerInvocation) const
+{
+    uint64_t blockSize = static_cast<uint64_t>(workgroupSize) * itemsPerInvocation;
+    return static_cast<uint32_t>(std::max<uint64_t>(1, (count + blockSize - 1) / blockSize));
+}
+
+void Primitives::fill(Job &job, Buffer &buffer, uint32_t count, uint32_t value)
+{
+    job.pushConstants(FillParams{ count, value })
+        .addTaskRange(tasks[Fill], { { &buffer } }, count);
+}
+
+void Primitives::scan(Job &job, Buffer &input, Buffer &output, uint32_t count, bool asFlags)
+{
+    uint32_t groups = getGroupCount(count, 1);
+    Buffer blockSums = job.createTransientBuffer(groups * sizeof(uint32_t));
+    job.pushConstants(ScanParams{ count, asFlags ? 1u : 0u })
+        .addTaskRange(tasks[Scan], { { &input, &output, &blockSums } }, count);
+
+    if (groups > 1)
+    {
+        Buffer blockOffsets = job.createTransientBuffer(groups * sizeof(uint32_t));
+        scan(job, blockSums, blockOffsets, groups, false);
+        job.pushConstants(CountParams{ count })
+            .addTaskRange(tasks[ScanAdd], { { &output, &blockOffsets } }, count);
+        job.releaseTransientBuffer(blockOffsets);
+    }
+    job.releaseTransientBuffer(blockSums);
+}
+
+const Task& Primitives::getHistogramTask(uint32_t binCount)
+{
+    std::lock_guard<std::mutex> lock(histogramMutex);
+
+    auto it = histogramTasks.find(binCount);
+    if (it == histogramTasks.end())
+    {
+        uint64_t sharedSize = (static_cast<uint64_t>(workgroupSize) + binCount) * sizeof(uint32_t);
+        if (sharedSize > manager.getComputeLimits().maxComputeSharedMemorySize)
+            throw std::runtime_error("Histogram bins do not fit into the shared memory of the device");
+
+        Task task = manager.createTask(getShaderPath("primitives_histogram"), workgroupSize, itemsPerInvocation, binCount);
+        it = histogramTasks.emplace(binCount, task).first;
+    }
+
+    return it->second;
+}
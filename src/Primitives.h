@@ -0,0 +1,152 @@
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include "JobManager.h"
+
+#include <vector>
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Parallel building blocks over arrays of uint32_t, recorded into existing jobs.
+ *
+ * Tasks are created once per manager from the shaders in src/shaders. Workgroup size and
+ * the number of elements per invocation are specialization constants picked from
+ * DeviceComputeLimits, and devices that support subgroup arithmetic and ballots in
+ * compute shaders use the variants of the shaders built on subgroup operations instead
+ * of shared memory only.
+ *
+ * Every function records one or more tasks and the barriers between them, intermediate
+ * data is kept in transient buffers of the job (see Job::createTransientBuffer()). Buffers
+ * are accessed as storage buffers, ranges of the buffers are supported as long as their
+ * offsets respect DeviceComputeLimits::minStorageBufferOffsetAlignment. Input and output
+ * buffers must not overlap unless stated otherwise.
+ */
+class Primitives
+{
+    enum Kernel
+    {
+        Fill,
+        Reduce,
+        Scan,
+        ScanAdd,
+        Compact,
+        RadixCount,
+        RadixScatter,
+        KernelCount
+    };
+
+    JobManager &manager;
+    std::string shaderDirectory;
+    std::string shaderSuffix;
+    uint32_t workgroupSize;
+    uint32_t itemsPerInvocation;
+    std::vector<Task> tasks;
+
+    // histogram tasks are specialized for the number of bins
+    std::mutex histogramMutex;
+    std::map<uint32_t, Task> histogramTasks;
+
+public:
+    /**
+     * @brief Create tasks of all primitives except for the histogram.
+     *
+     * @param manager Manager that creates the tasks and the jobs they are recorded into
+     * @param shaderDirectory Directory with the compiled shaders of the primitives
+     */
+    Primitives(JobManager &manager, const std::string &shaderDirectory = "../src/shaders");
+
+    Primitives(const Primitives&) = delete;
+    Primitives& operator=(const Primitives&) = delete;
+
+    /**
+     * @brief Get the number of invocations in the workgroups of the tasks.
+     */
+    uint32_t getWorkgroupSize() const;
+
+    /**
+     * @brief Check whether the tasks use subgroup operations.
+     */
+    bool usesSubgroups() const;
+
+    /**
+     * @brief Sum elements of the buffer.
+     *
+     * Every pass reduces blocks of workgroupSize * itemsPerInvocation elements to one
+     * partial sum until a single one is left. Sum wraps around on overflow.
+     *
+     * @param job Job to record the tasks into
+     * @param input Buffer with at least \p count elements
+     * @param output Buffer whose first element receives the sum
+     * @param count Number of elements to sum, 0 gives 0
+     * @return Reference to the job
+     */
+    Job& reduce(Job &job, Buffer &input, Buffer &output, uint32_t count);
+
+    /**
+     * @brief Compute exclusive prefix sum of the elements of the buffer.
+     *
+     * Workgroups scan their blocks and write block sums, which are scanned recursively
+     * and added back to the blocks.
+     *
+     * @param job Job to record the tasks into
+     * @param input Buffer with at least \p count elements
+     * @param output Buffer that receives \p count sums
+     * @param count Number of elements to scan
+     * @return Reference to the job
+     */
+    Job& exclusiveScan(Job &job, Buffer &input, Buffer &output, uint32_t count);
+
+    /**
+     * @brief Sort elements of the buffer in ascending order.
+     *
+     * Stable LSD radix sort with 4-bit digits, i.e. 8 passes of counting, scan of the
+     * counts and scatter. Result is written back to \p keys.
+     *
+     * @param job Job to record the tasks into
+     * @param keys Buffer with at least \p count elements
+     * @param count Number of elements to sort
+     * @return Reference to the job
+     */
+    Job& sort(Job &job, Buffer &keys, uint32_t count);
+
+    /**
+     * @brief Copy elements with non-zero flags to the beginning of the output, keeping
+     * their order.
+     *
+     * @param job Job to record the tasks into
+     * @param input Buffer with at least \p count elements
+     * @param flags Buffer with a flag per element, may be \p input itself to keep
+     * non-zero elements
+     * @param output Buffer large enough for all kept elements
+     * @param outputCount Buffer whose first element receives the number of kept elements
+     * @param count Number of elements of the input
+     * @return Reference to the job
+     */
+    Job& compact(Job &job, Buffer &input, Buffer &flags, Buffer &output, Buffer &outputCount, uint32_t count);
+
+    /**
+     * @brief Count occurrences of the values in the buffer.
+     *
+     * Every workgroup counts its elements with shared-memory atomics before adding them
+     * to the bins. Values not smaller than \p binCount are ignored.
+     *
+     * @param job Job to record the tasks into
+     * @param input Buffer with at least \p count elements
+     * @param bins Buffer that receives \p binCount counts, previous content is overwritten
+     * @param count Number of elements of the input
+     * @param binCount Number of bins, limited by DeviceComputeLimits::maxComputeSharedMemorySize
+     * @return Reference to the job
+     */
+    Job& histogram(Job &job, Buffer &input, Buffer &bins, uint32_t count, uint32_t binCount);
+
+private:
+    std::string getShaderPath(const std::string &name) const;
+    uint32_t getGroupCount(uint32_t count, uint32_t itemsPerInvocation) const;
+    void fill(Job &job, Buffer &buffer, uint32_t count, uint32_t value);
+    void scan(Job &job, Buffer &input, Buffer &output, uint32_t count, bool asFlags);
+    const Task& getHistogramTask(uint32_t binCount);
+};
+
+#endif // PRIMITIVES_H
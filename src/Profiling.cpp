@@ -0,0 +1,58 @@
+#include "Profiling.h"
+
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+static void writeJsonString(std::ostream &os, const std::string &value)
+{
+    os << '"';
+    for (char c : value)
+    {
+        switch (c)
+        {
+        case '"': os << "\\\""; break;
+        case '\\': os << "\\\\"; break;
+        case '\n': os << "\\n"; break;
+        case '\t': os << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+            else
+                os << c;
+        }
+    }
+    os << '"';
+}
+
+void writeChromeTrace(std::ostream &os, const std::vector<ProfilingRecord> &records)
+{
+    // complete events ("ph": "X") with timestamps and durations in microseconds
+    os << "{\"traceEvents\":[";
+    os << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        const auto &record = records[i];
+        os << (i > 0 ? "," : "") << "\n{\"name\":";
+        writeJsonString(os, record.name);
+        os << ",\"cat\":";
+        writeJsonString(os, record.category);
+        os << ",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << record.start / 1000.0
+           << ",\"dur\":" << record.duration / 1000.0;
+        if (record.invocations > 0)
+            os << ",\"args\":{\"invocations\":" << record.invocations << "}";
+        os << "}";
+    }
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+void saveChromeTrace(const std::string &path, const std::vector<ProfilingRecord> &records)
+{
+    std::ofstream ofs(path);
+    if (!ofs.is_open())
+    {
+        throw std::runtime_error("Failed to open trace file " + path);
+    }
+
+    writeChromeTrace(ofs, records);
+}
@@ -0,0 +1,48 @@
+#ifndef PROFILING_H
+#define PROFILING_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief GPU execution time of a single operation recorded into the job.
+ * 
+ * Times are measured with timestamp queries (see JobManagerSettings::enableProfiling)
+ * and converted to nanoseconds, so records of different jobs created by the same
+ * manager share the same time base. Times are zero if only pipeline statistics are
+ * collected.
+ */
+struct ProfilingRecord
+{
+    // name of the operation, e.g. name of the task that was dispatched
+    std::string name;
+    // kind of the operation: "task" or "transfer"
+    std::string category;
+    // start of the operation in nanoseconds, in the time domain of the device
+    double start = 0;
+    // duration of the operation in nanoseconds
+    double duration = 0;
+    // number of compute shader invocations of the task, 0 for transfers or if pipeline
+    // statistics are disabled
+    uint64_t invocations = 0;
+};
+
+/**
+ * @brief Write records in the Chrome trace event format, which can be opened with
+ * chrome://tracing or Perfetto.
+ * 
+ * @param os Stream to write JSON into
+ * @param records Records of one or more jobs (see Job::getProfilingResults())
+ */
+void writeChromeTrace(std::ostream &os, const std::vector<ProfilingRecord> &records);
+
+/**
+ * @brief Save records in the Chrome trace event format to the file.
+ * 
+ * @param path Path to the JSON file, overwritten if it exists
+ * @param records Records of one or more jobs (see Job::getProfilingResults())
+ */
+void saveChromeTrace(const std::string &path, const std::vector<ProfilingRecord> &records);
+
+#endif // PROFILING_H
@@ -4,13 +4,29 @@
 #include <vulkan/vulkan.h>
 
 #include <vector>
+#include <array>
+#include <string>
 #include <memory>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
 
 class JobManager;
 
 enum class ResourceType {
     StorageBuffer,
-    StorageImage
+    StorageImage,
+    // image with a sampler (combined image sampler descriptor, e.g. sampler2D in GLSL)
+    SampledImage,
+    UniformBuffer,
+    // buffers bound with the offset given at the time the descriptor set is bound, so
+    // ranges of the same buffer share a single descriptor set
+    StorageBufferDynamic,
+    UniformBufferDynamic,
+    // buffers read in the shaders as arrays of formatted texels (see TexelBufferView)
+    UniformTexelBuffer,
+    StorageTexelBuffer
 };
 
 enum AccessType : uint8_t {
@@ -24,28 +40,64 @@ struct AllocatedMemory
 {
     VkDeviceMemory memory = VK_NULL_HANDLE;
     VkDeviceSize offset = 0;
+    // pointer to persistently mapped memory, nullptr if memory is not host-visible
+    void* mappedData = nullptr;
 
     void* customData = nullptr;
 };
 
+/**
+ * @brief Memory usage of a single memory heap of the device.
+ * 
+ */
+struct MemoryHeapStatistics
+{
+    // size and flags of the heap as reported by the device
+    VkDeviceSize size = 0;
+    VkMemoryHeapFlags flags = 0;
+    // device memory allocated from the heap by the allocator
+    VkDeviceSize allocatedBytes = 0;
+    // part of the allocated memory occupied by buffers and images
+    VkDeviceSize usedBytes = 0;
+    // usage of the heap by the whole process and the amount of memory it can use without
+    // degrading performance; taken from VK_EXT_memory_budget when it is supported,
+    // otherwise estimated as allocatedBytes and 80% of the heap size
+    VkDeviceSize usage = 0;
+    VkDeviceSize budget = 0;
+};
+
+// Shared by all copies of a resource created by JobManager and by the jobs that use it.
+// Device objects of the resource are destroyed once the last reference is released.
+using ResourceLifetime = std::shared_ptr<const void>;
+
 class Resource
 {
     ResourceType resourceType;
     size_t size;
     AllocatedMemory allocatedMemory;
     size_t ID;
+    ResourceLifetime lifetime;
 
 protected:
     Resource() = delete;
-    Resource(ResourceType resourceType, size_t size, const AllocatedMemory& allocatedMemory) :
+    Resource(ResourceType resourceType, size_t size, const AllocatedMemory& allocatedMemory,
+            ResourceLifetime lifetime = nullptr) :
         resourceType(resourceType),
         size(size),
-        allocatedMemory(allocatedMemory)
+        allocatedMemory(allocatedMemory),
+        lifetime(std::move(lifetime))
     {
         static size_t nextID = 1;
         ID = nextID++;
     }
 
+    // same device resource bound through another type of descriptor
+    Resource(const Resource &other, ResourceType resourceType) :
+        Resource(other)
+    {
+        this->resourceType = resourceType;
+    }
+
 public:
     ResourceType getResourceType() const
     {
@@ -76,6 +128,16 @@ public:
     {
         return ID;
     }
+
+    /**
+     * @brief Get reference that keeps device objects of the resource alive.
+     * 
+     * @return Shared lifetime of the resource or nullptr if the resource is not owned by JobManager
+     */
+    const ResourceLifetime& getLifetime() const
+    {
+        return lifetime;
+    }
 };
 
 
@@ -85,12 +147,18 @@ public:
     enum class Type {
         DeviceLocal,
         Staging,
-        Uniform
+        Uniform,
+        // device-local memory that is also host-visible (resizable BAR, integrated GPUs)
+        DeviceMapped
     };
 
 private:
     VkBuffer buffer;
     Type bufferType;
+    // offset of the buffer's range inside the VkBuffer, non-zero for sub-allocated buffers
+    size_t offset;
+    // address of the buffer's range, 0 if buffer device addresses are not enabled
+    VkDeviceAddress deviceAddress;
 
     std::shared_ptr<Buffer> stagingBuffer;
 
@@ -99,21 +167,76 @@ public:
         Resource(ResourceType::StorageBuffer, 0, {}),
         buffer(VK_NULL_HANDLE),
         bufferType(Type::DeviceLocal),
+        offset(0),
+        deviceAddress(0),
         stagingBuffer(nullptr)
     {}
 
-    Buffer(VkBuffer buffer, const AllocatedMemory& allocatedMemory, size_t size, Type type = Type::DeviceLocal, Buffer *staging = nullptr) :
-        Resource(ResourceType::StorageBuffer, size, allocatedMemory),
+    Buffer(VkBuffer buffer, const AllocatedMemory& allocatedMemory, size_t size, Type type = Type::DeviceLocal, Buffer *staging = nullptr,
+            ResourceLifetime lifetime = nullptr, size_t offset = 0, VkDeviceAddress deviceAddress = 0) :
+        Resource(ResourceType::StorageBuffer, size, allocatedMemory, std::move(lifetime)),
         buffer(buffer),
         bufferType(type),
+        offset(offset),
+        deviceAddress(deviceAddress),
         stagingBuffer(staging)
     {}
 
+    /**
+     * @brief Construct buffer that refers to the range of another buffer.
+     * 
+     * Range shares VkBuffer, memory and staging buffer with \p buffer and keeps them alive.
+     * 
+     * @param buffer Buffer whose range is referred
+     * @param rangeOffset Offset of the range inside \p buffer in bytes
+     * @param rangeSize Size of the range in bytes, clamped to the end of \p buffer
+     */
+    Buffer(const Buffer &buffer, size_t rangeOffset, size_t rangeSize) :
+        Resource(ResourceType::StorageBuffer, std::min(rangeSize, buffer.getSize() - std::min(rangeOffset, buffer.getSize())),
+            buffer.GetAllocatedMemory(), buffer.getLifetime()),
+        buffer(buffer.buffer),
+        bufferType(buffer.bufferType),
+        offset(buffer.offset + rangeOffset),
+        deviceAddress(buffer.deviceAddress ? buffer.deviceAddress + rangeOffset : 0),
+        stagingBuffer(buffer.stagingBuffer)
+    {
+        if (rangeOffset > buffer.getSize())
+            throw std::runtime_error("Range starts outside of the buffer");
+    }
+
+protected:
+    Buffer(const Buffer &other, ResourceType resourceType) :
+        Resource(other, resourceType),
+        buffer(other.buffer),
+        bufferType(other.bufferType),
+        offset(other.offset),
+        deviceAddress(other.deviceAddress),
+        stagingBuffer(other.stagingBuffer)
+    {}
+
+public:
     VkBuffer getBuffer() const
     {
         return buffer;
     }
 
+    /**
+     * @brief Get offset (in bytes) of the buffer's data inside VkBuffer returned by getBuffer().
+     * 
+     * Zero for all buffers except the ones that share VkBuffer with others (see
+     * Job::createTransientBuffer() and BufferView).
+     */
+    size_t getOffset() const
+    {
+        return offset;
+    }
+
+    /**
+     * @brief Get staging buffer of the whole VkBuffer.
+     * 
+     * Buffers that refer to the range of another buffer share its staging buffer, their data
+     * is placed at getOffset() inside of it.
+     */
     Buffer* getStagingBuffer() const
     {
         return stagingBuffer.get();
@@ -123,54 +246,302 @@ public:
     {
         return bufferType;
     }
+
+    /**
+     * @brief Get device address of the buffer's data, e.g. to pass it to the shaders through
+     * push constants (GL_EXT_buffer_reference) instead of binding the buffer.
+     * 
+     * @return Address of the first byte of the buffer's range or 0 if
+     * JobManagerSettings::enableBufferDeviceAddress is not set or not supported, and for
+     * staging buffers
+     */
+    VkDeviceAddress getDeviceAddress() const
+    {
+        return deviceAddress;
+    }
+
+    /**
+     * @brief Get pointer to the mapped memory of the buffer.
+     * 
+     * Staging, Uniform and DeviceMapped buffers (as well as staging buffers of DeviceLocal
+     * ones) are mapped once at creation and stay mapped, so data can be written there directly.
+     * 
+     * @return Pointer to the mapped memory of the buffer's range or nullptr if buffer is
+     * not host-visible
+     */
+    void* data() const
+    {
+        void *mappedData = GetAllocatedMemory().mappedData;
+        return mappedData ? static_cast<char*>(mappedData) + offset : nullptr;
+    }
+};
+
+
+/**
+ * @brief Typed range of the buffer elements.
+ * 
+ * View is a Buffer that refers to the part of another buffer, so it can be used in place of
+ * the whole buffer. When it is bound to the task, descriptor covers only the range of the
+ * view, which therefore has to start at a multiple of
+ * DeviceComputeLimits::minStorageBufferOffsetAlignment. Transfers of the view copy only its
+ * bytes, e.g. to update a small part of a large buffer.
+ * 
+ * @tparam T Type of the elements
+ */
+template <typename T>
+class BufferView : public Buffer
+{
+    size_t first;
+
+public:
+    /**
+     * @brief Construct a new Buffer View object.
+     * 
+     * @param buffer Viewed buffer or a range of it, e.g. another view
+     * @param first Index of the first element of the view
+     * @param count Number of elements in the view, clamped to the end of \p buffer
+     */
+    BufferView(const Buffer &buffer, size_t first = 0, size_t count = SIZE_MAX) :
+        Buffer(buffer, first * sizeof(T), count > SIZE_MAX / sizeof(T) ? SIZE_MAX : count * sizeof(T)),
+        first(first)
+    {}
+
+    /**
+     * @brief Get index of the first element of the view inside the buffer passed to the constructor.
+     */
+    size_t getFirst() const
+    {
+        return first;
+    }
+
+    /**
+     * @brief Get number of the whole elements in the view.
+     */
+    size_t getCount() const
+    {
+        return getSize() / sizeof(T);
+    }
+
+    /**
+     * @brief Get pointer to the first element in the mapped memory (see Buffer::data()).
+     */
+    T* data() const
+    {
+        return static_cast<T*>(Buffer::data());
+    }
+};
+
+
+/**
+ * @brief Buffer bound to the shaders as a texel buffer (e.g. imageBuffer or samplerBuffer in GLSL).
+ *
+ * Refers to the same range of the same VkBuffer as the Buffer it was created from (see
+ * JobManager::createTexelBufferView()) and can be bound both as a uniform and as a storage
+ * texel buffer. Transfers of the texel buffer are the ones of its buffer.
+ */
+class TexelBufferView : public Buffer
+{
+    VkBufferView view;
+    VkFormat format;
+
+public:
+    TexelBufferView() :
+        Buffer(Buffer(), ResourceType::StorageTexelBuffer),
+        view(VK_NULL_HANDLE),
+        format(VK_FORMAT_UNDEFINED)
+    {}
+
+    TexelBufferView(const Buffer &buffer, VkBufferView view, VkFormat format) :
+        Buffer(buffer, ResourceType::StorageTexelBuffer),
+        view(view),
+        format(format)
+    {}
+
+    VkBufferView getView() const
+    {
+        return view;
+    }
+
+    VkFormat getFormat() const
+    {
+        return format;
+    }
 };
 
 
+/**
+ * @brief Parameters of the image created by JobManager::createImage().
+ */
+struct ImageCreateInfo
+{
+    size_t width = 0;
+    size_t height = 0;
+    VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+    // number of mip levels, at most floor(log2(max(width, height))) + 1
+    uint32_t mipLevels = 1;
+    uint32_t arrayLayers = 1;
+};
+
+// number of channels and size of a single texel of the uncompressed color format
+static std::pair<size_t, size_t> getFormatTexelInfo(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_R8_UINT:
+        return { 1, 1 };
+    case VK_FORMAT_R8G8_UNORM:
+        return { 2, 2 };
+    case VK_FORMAT_R16_UNORM:
+    case VK_FORMAT_R16_UINT:
+    case VK_FORMAT_R16_SFLOAT:
+        return { 1, 2 };
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_UINT:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+        return { 4, 4 };
+    case VK_FORMAT_R16G16_SFLOAT:
+        return { 2, 4 };
+    case VK_FORMAT_R32_UINT:
+    case VK_FORMAT_R32_SINT:
+    case VK_FORMAT_R32_SFLOAT:
+        return { 1, 4 };
+    case VK_FORMAT_R16G16B16A16_UNORM:
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+        return { 4, 8 };
+    case VK_FORMAT_R32G32_SFLOAT:
+        return { 2, 8 };
+    case VK_FORMAT_R32G32B32A32_UINT:
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+        return { 4, 16 };
+    default:
+        throw std::runtime_error("Unsupported image format: " + std::to_string(format));
+    }
+}
+
+
+/**
+ * @brief 2D image, optionally with several mip levels and array layers.
+ *
+ * Data of the image in the host memory and in the staging buffer is stored level by level,
+ * with the texels of all array layers of the level tightly packed one layer after another.
+ * Levels start at offsets aligned to 16 bytes, see getMipLevelOffset().
+ */
 class Image : public Resource
 {
     VkImage image;
     VkImageView imageView;
+    // view of the first mip level, storage images are bound with a single level
+    VkImageView storageView;
     size_t width;
     size_t height;
     size_t channels;
-    VkImageLayout layout;
+    size_t texelSize;
+    VkFormat format;
+    uint32_t mipLevels;
+    uint32_t arrayLayers;
+    // shared by all copies, so that they agree on the layout of the device image
+    std::shared_ptr<VkImageLayout> layout;
 
     std::shared_ptr<Buffer> stagingBuffer;
-    
-public:
-    Image() :
-        Resource(ResourceType::StorageImage, 0, {}),
+
+    static constexpr size_t mipLevelAlignment = 16;
+
+protected:
+    Image(ResourceType resourceType) :
+        Resource(resourceType, 0, {}),
         image(VK_NULL_HANDLE),
         imageView(VK_NULL_HANDLE),
+        storageView(VK_NULL_HANDLE),
         width(0),
         height(0),
         channels(0),
-        layout(VK_IMAGE_LAYOUT_UNDEFINED),
+        texelSize(0),
+        format(VK_FORMAT_UNDEFINED),
+        mipLevels(0),
+        arrayLayers(0),
+        layout(std::make_shared<VkImageLayout>(VK_IMAGE_LAYOUT_UNDEFINED)),
         stagingBuffer(nullptr)
     {}
 
-    Image(VkImage image, const AllocatedMemory& allocatedMemory, VkImageView imageView, size_t width, size_t height,
-            size_t channels, Buffer *staging = nullptr, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED) :
-        Resource(ResourceType::StorageImage, width * height * channels, allocatedMemory),
+    Image(const Image &other, ResourceType resourceType) :
+        Resource(other, resourceType),
+        image(other.image),
+        imageView(other.imageView),
+        storageView(other.storageView),
+        width(other.width),
+        height(other.height),
+        channels(other.channels),
+        texelSize(other.texelSize),
+        format(other.format),
+        mipLevels(other.mipLevels),
+        arrayLayers(other.arrayLayers),
+        layout(other.layout),
+        stagingBuffer(other.stagingBuffer)
+    {}
+
+public:
+    Image() :
+        Image(ResourceType::StorageImage)
+    {}
+
+    Image(VkImage image, const AllocatedMemory& allocatedMemory, VkImageView imageView, VkImageView storageView,
+            const ImageCreateInfo &info, Buffer *staging = nullptr, VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED,
+            ResourceLifetime lifetime = nullptr) :
+        Resource(ResourceType::StorageImage, computeSize(info), allocatedMemory, std::move(lifetime)),
         image(image),
         imageView(imageView),
-        width(width),
-        height(height),
-        channels(channels),
-        layout(layout),
+        storageView(storageView),
+        width(info.width),
+        height(info.height),
+        channels(getFormatTexelInfo(info.format).first),
+        texelSize(getFormatTexelInfo(info.format).second),
+        format(info.format),
+        mipLevels(info.mipLevels),
+        arrayLayers(info.arrayLayers),
+        layout(std::make_shared<VkImageLayout>(layout)),
         stagingBuffer(staging)
     {}
 
+    /**
+     * @brief Get size of the data of the image with the given parameters (in bytes).
+     */
+    static size_t computeSize(const ImageCreateInfo &info)
+    {
+        size_t texelSize = getFormatTexelInfo(info.format).second;
+        size_t size = 0;
+        for (uint32_t level = 0; level < info.mipLevels; ++level)
+        {
+            size = (size + mipLevelAlignment - 1) / mipLevelAlignment * mipLevelAlignment;
+            size += std::max<size_t>(1, info.width >> level) * std::max<size_t>(1, info.height >> level) *
+                info.arrayLayers * texelSize;
+        }
+        return size;
+    }
+
     VkImage getImage() const
     {
         return image;
     }
 
+    /**
+     * @brief Get view of all mip levels and array layers of the image.
+     */
     VkImageView getView() const
     {
         return imageView;
     }
 
+    /**
+     * @brief Get view of the first mip level and all array layers of the image.
+     */
+    VkImageView getStorageView() const
+    {
+        return storageView;
+    }
+
     size_t getWidth() const
     {
         return width;
@@ -186,14 +557,68 @@ public:
         return channels;
     }
 
+    /**
+     * @brief Get size of a single texel (in bytes).
+     */
+    size_t getTexelSize() const
+    {
+        return texelSize;
+    }
+
+    VkFormat getFormat() const
+    {
+        return format;
+    }
+
+    uint32_t getMipLevels() const
+    {
+        return mipLevels;
+    }
+
+    uint32_t getArrayLayers() const
+    {
+        return arrayLayers;
+    }
+
+    size_t getMipWidth(uint32_t level) const
+    {
+        return std::max<size_t>(1, width >> level);
+    }
+
+    size_t getMipHeight(uint32_t level) const
+    {
+        return std::max<size_t>(1, height >> level);
+    }
+
+    /**
+     * @brief Get offset of the mip level in the data of the image.
+     *
+     * @param level Mip level
+     * @return Offset (in bytes), multiple of 16
+     */
+    size_t getMipLevelOffset(uint32_t level) const
+    {
+        // size of the previous levels does not include the padding before this one
+        size_t size = computeSize({ width, height, format, level, arrayLayers });
+        return (size + mipLevelAlignment - 1) / mipLevelAlignment * mipLevelAlignment;
+    }
+
+    /**
+     * @brief Get size of the mip level including all array layers (in bytes).
+     */
+    size_t getMipLevelSize(uint32_t level) const
+    {
+        return getMipWidth(level) * getMipHeight(level) * arrayLayers * texelSize;
+    }
+
     VkImageLayout getLayout() const
     {
-        return layout;
+        return *layout;
     }
 
     void setLayout(VkImageLayout layout)
     {
-        this->layout = layout;
+        *this->layout = layout;
     }
 
     Buffer* getStagingBuffer() const
@@ -203,20 +628,58 @@ public:
 };
 
 
+/**
+ * @brief Image that is read by the shaders through a sampler.
+ *
+ * Refers to the same device image as the Image it was created from (see
+ * JobManager::createSampledImage()), so transfers into either of them are visible to both.
+ * Shaders can only read sampled images.
+ */
+class SampledImage : public Image
+{
+    VkSampler sampler;
+
+public:
+    SampledImage() :
+        Image(ResourceType::SampledImage),
+        sampler(VK_NULL_HANDLE)
+    {}
+
+    SampledImage(const Image &image, VkSampler sampler) :
+        Image(image, ResourceType::SampledImage),
+        sampler(sampler)
+    {}
+
+    VkSampler getSampler() const
+    {
+        return sampler;
+    }
+};
+
+
 class ResourceSet
 {
     VkDescriptorSet descriptorSet;
     std::vector<Resource *> resources;
+    // resources referenced by the descriptor set are kept alive as long as the set
+    std::vector<ResourceLifetime> lifetimes;
+    // offsets of the dynamic buffers, in the order of their bindings
+    std::vector<uint32_t> dynamicOffsets;
 
 public:
     ResourceSet() :
         descriptorSet(VK_NULL_HANDLE)
     {}
 
-    ResourceSet(VkDescriptorSet descriptorSet, const std::vector<Resource *> &resources = {}) :
+    ResourceSet(VkDescriptorSet descriptorSet, const std::vector<Resource *> &resources = {},
+            const std::vector<uint32_t> &dynamicOffsets = {}) :
         descriptorSet(descriptorSet),
-        resources(resources)
-    {}
+        resources(resources),
+        dynamicOffsets(dynamicOffsets)
+    {
+        for (const auto resource : resources)
+            lifetimes.push_back(resource->getLifetime());
+    }
 
     VkDescriptorSet getDescriptorSet() const
     {
@@ -227,6 +690,11 @@ public:
     {
         return resources;
     }
+
+    const std::vector<uint32_t>& getDynamicOffsets() const
+    {
+        return dynamicOffsets;
+    }
 };
 
 
@@ -236,14 +704,22 @@ class Task
     VkPipelineLayout pipelineLayout;
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
     std::vector<std::vector<AccessTypeFlags>> resourceAccessFlags; 
+    std::string name;
+    std::array<uint32_t, 3> localSize;
+    std::vector<std::vector<ResourceType>> resourceTypes;
 
 public:
 
-    Task(VkPipeline pipeline, VkPipelineLayout pipelineLayout, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, const std::vector<std::vector<AccessTypeFlags>>& resourceAccessFlags) :
+    Task(VkPipeline pipeline, VkPipelineLayout pipelineLayout, const std::vector<VkDescriptorSetLayout>& descriptorSetLayouts, const std::vector<std::vector<AccessTypeFlags>>& resourceAccessFlags,
+            const std::string &name = "", const std::array<uint32_t, 3> &localSize = { 1, 1, 1 },
+            const std::vector<std::vector<ResourceType>> &resourceTypes = {}) :
         pipeline(pipeline),
         pipelineLayout(pipelineLayout),
         descriptorSetLayouts(descriptorSetLayouts),
-        resourceAccessFlags(resourceAccessFlags)
+        resourceAccessFlags(resourceAccessFlags),
+        name(name),
+        localSize(localSize),
+        resourceTypes(resourceTypes)
     {}
 
     VkPipeline getPipeline() const
@@ -270,6 +746,45 @@ public:
     {
         return resourceAccessFlags;
     }
+
+    /**
+     * @brief Get types of the bindings of every descriptor set, as declared in the shader.
+     * 
+     * Resources bound to the task are written to the descriptor sets with these types,
+     * e.g. Buffer can be bound as a uniform or a dynamic buffer. Empty if the task was not
+     * created by JobManager, then types of the resources themselves are used.
+     */
+    const std::vector<std::vector<ResourceType>>& getResourceTypes() const
+    {
+        return resourceTypes;
+    }
+
+    /**
+     * @brief Get name of the task used in debug labels and profiling results.
+     * 
+     * Tasks created by JobManager are named after their shader file unless another
+     * name is set.
+     */
+    const std::string& getName() const
+    {
+        return name;
+    }
+
+    Task& setName(const std::string &newName)
+    {
+        name = newName;
+        return *this;
+    }
+
+    /**
+     * @brief Get size of the local workgroup of the task.
+     * 
+     * Reflected from the shader, including sizes set with specialization constants.
+     */
+    const std::array<uint32_t, 3>& getLocalSize() const
+    {
+        return localSize;
+    }
 };
 
 
@@ -294,6 +809,26 @@ public:
 };
 
 
+static bool isImageResource(ResourceType type)
+{
+    return type == ResourceType::StorageImage || type == ResourceType::SampledImage;
+}
+
+static bool isBufferResource(ResourceType type)
+{
+    return !isImageResource(type);
+}
+
+static bool isDynamicResource(ResourceType type)
+{
+    return type == ResourceType::StorageBufferDynamic || type == ResourceType::UniformBufferDynamic;
+}
+
+static bool isTexelBufferResource(ResourceType type)
+{
+    return type == ResourceType::UniformTexelBuffer || type == ResourceType::StorageTexelBuffer;
+}
+
 static VkDescriptorType resourceToDescriptorType(ResourceType type)
 {
     switch (type)
@@ -302,6 +837,18 @@ static VkDescriptorType resourceToDescriptorType(ResourceType type)
         return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
     case ResourceType::StorageImage:
         return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    case ResourceType::SampledImage:
+        return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    case ResourceType::UniformBuffer:
+        return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    case ResourceType::StorageBufferDynamic:
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+    case ResourceType::UniformBufferDynamic:
+        return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    case ResourceType::UniformTexelBuffer:
+        return VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+    case ResourceType::StorageTexelBuffer:
+        return VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
     }
 
     return VK_DESCRIPTOR_TYPE_MAX_ENUM;
@@ -0,0 +1,102 @@
+#include "StagingRingBuffer.h"
+
+#include <stdexcept>
+#include <algorithm>
+
+StagingRingBuffer::StagingRingBuffer(VkDevice device, const Buffer &buffer, size_t alignment) :
+    device(device),
+    buffer(buffer),
+    alignment(alignment)
+{}
+
+const Buffer& StagingRingBuffer::getBuffer() const
+{
+    return buffer;
+}
+
+StagingRegion StagingRingBuffer::allocate(size_t size, const std::vector<StagingRegion> &reserved)
+{
+    if (size > buffer.getSize())
+    {
+        throw std::runtime_error("Transfer does not fit into the staging buffer");
+    }
+
+    // wrap around if there is not enough space left till the end of the buffer
+    if (head + size > buffer.getSize())
+    {
+        head = 0;
+    }
+
+    StagingRegion region{ head, size };
+    for (const auto &other : reserved)
+    {
+        if (overlap(region, other))
+        {
+            throw std::runtime_error("Transfers of a single job do not fit into the staging buffer");
+        }
+    }
+
+    head = (head + size + alignment - 1) / alignment * alignment;
+
+    return region;
+}
+
+void StagingRingBuffer::acquire(const std::vector<StagingRegion> &regions, VkFence fence, VkFence owner)
+{
+    std::vector<VkFence> fences;
+    for (const auto &busy : busyRegions)
+    {
+        bool overlaps = std::any_of(regions.begin(), regions.end(), [&busy](const StagingRegion &region) {
+            return overlap(region, busy.region);
+        });
+        if (busy.fence == fence)
+        {
+            // regions of another job from the same batched submission can not be waited for
+            if (overlaps)
+                throw std::runtime_error("Transfers of the batched jobs do not fit into the staging buffer");
+            continue;
+        }
+
+        if (overlaps && busy.region.readback)
+        {
+            // readback data stays in the staging buffer until its job is awaited
+            throw std::runtime_error("Transfers overlap with the staging buffer readbacks of the job that was not awaited yet");
+        }
+
+        if (overlaps && std::find(fences.begin(), fences.end(), busy.fence) == fences.end())
+        {
+            fences.push_back(busy.fence);
+        }
+    }
+
+    if (fences.size() > 0)
+    {
+        if (vkWaitForFences(device, static_cast<uint32_t>(fences.size()), fences.data(), VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+        {
+            throw std::runtime_error("Failed to wait for fence!");
+        }
+
+        // uploads of the finished jobs are consumed, but their readbacks are copied to the
+        // host only when the jobs are awaited
+        busyRegions.erase(std::remove_if(busyRegions.begin(), busyRegions.end(), [&fences](const BusyRegion &busy) {
+            return !busy.region.readback && std::find(fences.begin(), fences.end(), busy.fence) != fences.end();
+        }), busyRegions.end());
+    }
+
+    for (const auto &region : regions)
+    {
+        busyRegions.push_back({ region, fence, owner });
+    }
+}
+
+void StagingRingBuffer::release(VkFence fence, VkFence owner)
+{
+    busyRegions.erase(std::remove_if(busyRegions.begin(), busyRegions.end(), [fence, owner](const BusyRegion &busy) {
+        return busy.fence == fence && (owner == VK_NULL_HANDLE || busy.owner == owner);
+    }), busyRegions.end());
+}
+
+bool StagingRingBuffer::overlap(const StagingRegion &a, const StagingRegion &b)
+{
+    return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+}
@@ -0,0 +1,103 @@
+#ifndef STAGING_RING_BUFFER_H
+#define STAGING_RING_BUFFER_H
+
+#include "Resources.h"
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+/**
+ * @brief Range of the staging ring buffer used by a single transfer.
+ *
+ */
+struct StagingRegion
+{
+    size_t offset = 0;
+    size_t size = 0;
+    // region receives data read back to the host, which is copied out only when the job
+    // is awaited
+    bool readback = false;
+};
+
+/**
+ * @brief Host-visible buffer of fixed size shared by all transfers of the JobManager.
+ *
+ * Regions are handed out in ring order when transfer is recorded into the job. Since
+ * host-side copies take place only when the job is submitted, region is considered busy
+ * only from the submission of the job that uses it until that job is awaited. Submission
+ * of the job whose regions overlap with busy ones waits for the jobs that use them; upload
+ * regions of the finished jobs are reused right away, while readback regions stay busy
+ * until their data is copied out by Job::await().
+ */
+class StagingRingBuffer
+{
+    struct BusyRegion
+    {
+        StagingRegion region;
+        VkFence fence;
+        // own fence of the job, jobs of a batched submission share the other one
+        VkFence owner;
+    };
+
+    VkDevice device;
+    Buffer buffer;
+    size_t alignment;
+    size_t head = 0;
+
+    std::vector<BusyRegion> busyRegions;
+
+public:
+    /**
+     * @brief Construct a new Staging Ring Buffer object.
+     *
+     * @param device Logical device that was used to create \p buffer
+     * @param buffer Host-visible buffer that will be divided between transfers
+     * @param alignment Alignment of the offsets of all allocated regions
+     */
+    StagingRingBuffer(VkDevice device, const Buffer &buffer, size_t alignment);
+
+    /**
+     * @brief Get underlying buffer.
+     */
+    const Buffer& getBuffer() const;
+
+    /**
+     * @brief Allocate next region of the ring.
+     *
+     * @param size Size of the region in bytes
+     * @param reserved Regions already allocated by the same job, which must not be
+     * overlapped by the new one
+     * @return Allocated region
+     */
+    StagingRegion allocate(size_t size, const std::vector<StagingRegion> &reserved);
+
+    /**
+     * @brief Mark regions as busy until the job that signals \p fence is awaited.
+     *
+     * Blocks until all jobs whose busy regions overlap with \p regions are finished.
+     * Throws if \p regions overlap with busy regions acquired with the same \p fence, i.e.
+     * by another job of the same batched submission, or with readback regions of the
+     * jobs that were not awaited yet.
+     *
+     * @param regions Regions used by the job that is going to be submitted
+     * @param fence Fence signaled by the submission of that job
+     * @param owner Own fence of that job, which identifies its regions in the batch
+     */
+    void acquire(const std::vector<StagingRegion> &regions, VkFence fence, VkFence owner);
+
+    /**
+     * @brief Retire regions that were acquired with \p fence.
+     *
+     * @param fence Fence of the completed submission
+     * @param owner Own fence of the job whose regions are retired, all regions of the
+     * submission are retired if VK_NULL_HANDLE
+     */
+    void release(VkFence fence, VkFence owner = VK_NULL_HANDLE);
+
+    /**
+     * @brief Check whether two regions share any byte of the buffer.
+     */
+    static bool overlap(const StagingRegion &a, const StagingRegion &b);
+};
+
+#endif // STAGING_RING_BUFFER_H
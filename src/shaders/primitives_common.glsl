@@ -0,0 +1,112 @@
+// Shared part of the compute primitives (see Primitives.h), included right after the
+// version directive. USE_SUBGROUPS selects the variant built on subgroup arithmetic.
+// Subgroups do not have to be full nor of the size reported by the device, partial
+// results of the subgroups are combined by the active invocations of the first one.
+
+#ifdef USE_SUBGROUPS
+#extension GL_KHR_shader_subgroup_basic : require
+#extension GL_KHR_shader_subgroup_arithmetic : require
+#extension GL_KHR_shader_subgroup_ballot : require
+#endif
+
+layout (local_size_x_id = 0) in;
+
+// number of elements reduced or counted by every invocation
+layout (constant_id = 1) const uint ITEMS_PER_INVOCATION = 1;
+
+shared uint scratch[gl_WorkGroupSize.x];
+
+// Sum of the values of all invocations of the workgroup.
+// Has to be called in uniform control flow.
+uint workgroupAdd(uint value)
+{
+#ifdef USE_SUBGROUPS
+    uint sum = subgroupAdd(value);
+    if (subgroupElect())
+        scratch[gl_SubgroupID] = sum;
+    barrier();
+    if (gl_SubgroupID == 0)
+    {
+        // every active invocation sums every activeCount-th partial result
+        uvec4 active = subgroupBallot(true);
+        uint activeCount = subgroupBallotBitCount(active);
+        uint partial = 0;
+        for (uint i = subgroupBallotExclusiveBitCount(active); i < gl_NumSubgroups; i += activeCount)
+            partial += scratch[i];
+        partial = subgroupAdd(partial);
+        if (subgroupElect())
+            scratch[0] = partial;
+    }
+    barrier();
+    uint total = scratch[0];
+    barrier();
+    return total;
+#else
+    uint id = gl_LocalInvocationID.x;
+    scratch[id] = value;
+    barrier();
+    for (uint offset = gl_WorkGroupSize.x / 2; offset > 0; offset /= 2)
+    {
+        if (id < offset)
+            scratch[id] += scratch[id + offset];
+        barrier();
+    }
+    uint total = scratch[0];
+    barrier();
+    return total;
+#endif
+}
+
+// Exclusive prefix sum of the values in the order of the local invocation indices,
+// total receives sum of all values. Has to be called in uniform control flow.
+uint workgroupExclusiveAdd(uint value, out uint total)
+{
+#ifdef USE_SUBGROUPS
+    // highest active invocation holds the sum of the whole subgroup
+    uint inclusive = subgroupInclusiveAdd(value);
+    if (gl_SubgroupInvocationID == subgroupBallotFindMSB(subgroupBallot(true)))
+        scratch[gl_SubgroupID] = inclusive;
+    barrier();
+    if (gl_SubgroupID == 0)
+    {
+        // partial results are scanned in chunks of the size of the active invocations
+        uvec4 active = subgroupBallot(true);
+        uint activeCount = subgroupBallotBitCount(active);
+        uint rank = subgroupBallotExclusiveBitCount(active);
+        uint sum = 0;
+        for (uint first = 0; first < gl_NumSubgroups; first += activeCount)
+        {
+            uint i = first + rank;
+            bool hasPartial = i < gl_NumSubgroups;
+            uint partial = hasPartial ? scratch[i] : 0;
+            uint partialPrefix = subgroupExclusiveAdd(partial);
+            if (hasPartial)
+                scratch[i] = sum + partialPrefix;
+            sum += subgroupAdd(partial);
+        }
+        if (subgroupElect())
+            scratch[gl_NumSubgroups] = sum;
+    }
+    barrier();
+    total = scratch[gl_NumSubgroups];
+    uint result = inclusive - value + scratch[gl_SubgroupID];
+    barrier();
+    return result;
+#else
+    // Hillis-Steele scan
+    uint id = gl_LocalInvocationID.x;
+    scratch[id] = value;
+    barrier();
+    for (uint offset = 1; offset < gl_WorkGroupSize.x; offset *= 2)
+    {
+        uint previous = id >= offset ? scratch[id - offset] : 0;
+        barrier();
+        scratch[id] += previous;
+        barrier();
+    }
+    total = scratch[gl_WorkGroupSize.x - 1];
+    uint result = scratch[id] - value;
+    barrier();
+    return result;
+#endif
+}
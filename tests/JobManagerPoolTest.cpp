@@ -0,0 +1,84 @@
+#include "catch.hpp"
+
+#include "JobManagerPool.h"
+
+#include <vector>
+
+
+TEST_CASE("JobManagerPool tests", "[JobManagerPool]")
+{
+    JobManagerPool pool;
+
+    REQUIRE(pool.getManagerCount() >= 1);
+    REQUIRE(pool.getManagerCount() == pool.getManager(0).getSuitableDeviceCount());
+
+    SECTION("Limited device count")
+    {
+        JobManagerPool singlePool({}, {}, 1);
+        REQUIRE(singlePool.getManagerCount() == 1);
+    }
+
+    SECTION("Round robin")
+    {
+        std::vector<JobManager *> picked;
+        for (size_t i = 0; i < 2 * pool.getManagerCount(); ++i)
+            picked.push_back(&pool.pickManager(DistributionPolicy::RoundRobin));
+
+        for (size_t i = 0; i < pool.getManagerCount(); ++i)
+        {
+            REQUIRE(picked[i] == &pool.getManager(i));
+            REQUIRE(picked[i + pool.getManagerCount()] == &pool.getManager(i));
+        }
+    }
+
+    SECTION("Least loaded")
+    {
+        REQUIRE(&pool.pickManager(DistributionPolicy::LeastLoaded) == &pool.getManager(0));
+
+        JobManager &manager = pool.pickManager(DistributionPolicy::LeastLoaded);
+        Job job = manager.createJob();
+        auto future = pool.submitAsync(job);
+        future.get();
+
+        // completed jobs do not count as load
+        REQUIRE(&pool.pickManager(DistributionPolicy::LeastLoaded) == &pool.getManager(0));
+    }
+
+    SECTION("Job of another manager")
+    {
+        JobManager manager;
+        Job job = manager.createJob();
+        REQUIRE_THROWS(pool.submitAsync(job));
+    }
+
+    SECTION("Range dispatch")
+    {
+        constexpr size_t count = 40;
+        std::vector<uint32_t> data(count);
+        std::vector<uint32_t> expected(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            data[i] = static_cast<uint32_t>(i % 10 + 1);
+            uint32_t prev = 0, curr = 1;
+            for (uint32_t n = 1; n < data[i]; ++n)
+            {
+                uint32_t next = prev + curr;
+                prev = curr;
+                curr = next;
+            }
+            expected[i] = curr;
+        }
+
+        pool.dispatchRange(count, [&](JobManager &manager, Job &job, size_t first, size_t partCount) {
+            size_t partSize = partCount * sizeof(uint32_t);
+            Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)partCount);
+            Buffer buffer = manager.createBuffer(partSize);
+
+            job.syncResourceToDevice(buffer, data.data() + first, partSize)
+                .addTaskRange(task, { { &buffer } }, static_cast<uint32_t>(partCount))
+                .syncResourceToHost(buffer, data.data() + first, partSize);
+        }, 8);
+
+        REQUIRE(data == expected);
+    }
+}
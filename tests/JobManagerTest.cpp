@@ -5,6 +5,8 @@
 
 #include "TestUtils.h"
 
+#include <cstdio>
+
 
 TEST_CASE("JobManager resource creation", "[JobManager]")
 {
@@ -29,14 +31,59 @@ TEST_CASE("JobManager resource creation", "[JobManager]")
             if (type == Buffer::Type::DeviceLocal)
             {
                 REQUIRE(buffer.getStagingBuffer() != nullptr);
+                REQUIRE(buffer.getStagingBuffer()->data() != nullptr);
+                REQUIRE(buffer.data() == nullptr);
             }
             else
             {
                 REQUIRE(buffer.getStagingBuffer() == nullptr);
+                REQUIRE(buffer.data() != nullptr);
             }
         }
     }
 
+    SECTION("DeviceMapped buffer created")
+    {
+        size_t size = 10;
+        Buffer buffer = manager.createBuffer(size, Buffer::Type::DeviceMapped);
+
+        REQUIRE(buffer.getBuffer() != VK_NULL_HANDLE);
+        REQUIRE(buffer.getSize() == size);
+        if (manager.supportsDeviceMappedBuffers())
+        {
+            REQUIRE(buffer.getBufferType() == Buffer::Type::DeviceMapped);
+            REQUIRE(buffer.getStagingBuffer() == nullptr);
+            REQUIRE(buffer.data() != nullptr);
+        }
+        else
+        {
+            // falls back to the staging copies
+            REQUIRE(buffer.getBufferType() == Buffer::Type::DeviceLocal);
+            REQUIRE(buffer.getStagingBuffer() != nullptr);
+        }
+    }
+
+    SECTION("Buffer view created")
+    {
+        Buffer buffer = manager.createBuffer(10 * sizeof(uint32_t), Buffer::Type::Staging);
+        BufferView<uint32_t> view(buffer, 2, 5);
+
+        REQUIRE(view.getBuffer() == buffer.getBuffer());
+        REQUIRE(view.getLifetime() == buffer.getLifetime());
+        REQUIRE(view.getOffset() == 2 * sizeof(uint32_t));
+        REQUIRE(view.getSize() == 5 * sizeof(uint32_t));
+        REQUIRE(view.getFirst() == 2);
+        REQUIRE(view.getCount() == 5);
+        REQUIRE(view.data() == static_cast<uint32_t*>(buffer.data()) + 2);
+
+        // clamped to the end of the buffer
+        BufferView<uint32_t> rest(view, 3);
+        REQUIRE(rest.getOffset() == 5 * sizeof(uint32_t));
+        REQUIRE(rest.getCount() == 2);
+
+        REQUIRE_THROWS(BufferView<uint32_t>(buffer, 11));
+    }
+
     SECTION("Image created")
     {
         size_t width = 10, height = 10;
@@ -51,6 +98,37 @@ TEST_CASE("JobManager resource creation", "[JobManager]")
         REQUIRE(image.getStagingBuffer() != nullptr);
     }
 
+    SECTION("Image created with format, mip levels and array layers")
+    {
+        Image image = manager.createImage({ 16, 8, VK_FORMAT_R32_SFLOAT, 3, 2 });
+
+        REQUIRE(image.getFormat() == VK_FORMAT_R32_SFLOAT);
+        REQUIRE(image.getChannels() == 1);
+        REQUIRE(image.getTexelSize() == sizeof(float));
+        REQUIRE(image.getMipLevels() == 3);
+        REQUIRE(image.getArrayLayers() == 2);
+        REQUIRE(image.getMipWidth(2) == 4);
+        REQUIRE(image.getMipHeight(2) == 2);
+        REQUIRE(image.getMipLevelOffset(1) == 16 * 8 * 2 * sizeof(float));
+        REQUIRE(image.getMipLevelOffset(2) == (16 * 8 + 8 * 4) * 2 * sizeof(float));
+        REQUIRE(image.getSize() == (16 * 8 + 8 * 4 + 4 * 2) * 2 * sizeof(float));
+        REQUIRE(image.getStagingBuffer()->getSize() == image.getSize());
+
+        // levels of odd sizes are padded to the alignment
+        Image odd = manager.createImage({ 3, 3, VK_FORMAT_R8_UNORM, 2, 1 });
+        REQUIRE(odd.getMipLevelOffset(1) == 16);
+        REQUIRE(odd.getSize() == 16 + 1);
+
+        SampledImage sampled = manager.createSampledImage(image, VK_FILTER_NEAREST);
+        REQUIRE(sampled.getResourceType() == ResourceType::SampledImage);
+        REQUIRE(sampled.getImage() == image.getImage());
+        REQUIRE(sampled.getSampler() != VK_NULL_HANDLE);
+        REQUIRE(manager.createSampledImage(image, VK_FILTER_NEAREST).getSampler() == sampled.getSampler());
+
+        REQUIRE_THROWS(manager.createImage({ 16, 8, VK_FORMAT_R32_SFLOAT, 6 }));
+        REQUIRE_THROWS(manager.createImage({ 16, 8, VK_FORMAT_UNDEFINED }));
+    }
+
     SECTION("Job created")
     {
         Job job = manager.createJob();
@@ -59,17 +137,97 @@ TEST_CASE("JobManager resource creation", "[JobManager]")
         REQUIRE(job.getCommandBuffer() != VK_NULL_HANDLE);
     }
 
+    SECTION("Job objects recycled")
+    {
+        VkCommandBuffer commandBuffer;
+        {
+            Job job = manager.createJob();
+            commandBuffer = job.getCommandBuffer();
+            job.submit();
+            REQUIRE(job.await());
+        }
+
+        Job job = manager.createJob();
+        REQUIRE(job.getCommandBuffer() == commandBuffer);
+        REQUIRE(job.isComplete() == true);
+    }
+
     SECTION("Task created")
     {
         SECTION("without specialized constants")
         {
             Task task = manager.createTask("../examples/shaders/fibonacci.spv");
+            REQUIRE(task.getName() == "fibonacci");
         }
 
         SECTION("With specialized constants")
         {
             Task task = manager.createTask("../examples/shaders/fibonacci.spv", 20);
         }
+
+        SECTION("with local size")
+        {
+            Task task = manager.createTask("../examples/shaders/fibonacci.spv");
+            REQUIRE(task.getLocalSize() == std::array<uint32_t, 3>{ 1, 1, 1 });
+
+            Task specialized = manager.createTask("../examples/shaders/edgedetect.spv", 16, 8);
+            REQUIRE(specialized.getLocalSize() == std::array<uint32_t, 3>{ 16, 8, 1 });
+        }
+
+        SECTION("sharing pipeline")
+        {
+            Task task1 = manager.createTask("../examples/shaders/fibonacci.spv", 20);
+            Task task2 = manager.createTask("../examples/shaders/fibonacci.spv", 20);
+            Task task3 = manager.createTask("../examples/shaders/fibonacci.spv", 10);
+            Task task4 = manager.createTask("../examples/shaders/fibonacci.spv");
+
+            REQUIRE(task1.getPipeline() == task2.getPipeline());
+            REQUIRE(task1.getPipeline() != task3.getPipeline());
+            REQUIRE(task1.getPipeline() != task4.getPipeline());
+            REQUIRE(task1.getPipelineLayout() == task3.getPipelineLayout());
+            REQUIRE(task1.getDescriptorSetLayout(0) == task4.getDescriptorSetLayout(0));
+        }
+
+        SECTION("in batch")
+        {
+            std::vector<Task> tasks = manager.createTasks({
+                { "../examples/shaders/fibonacci.spv", 20 },
+                { "../examples/shaders/sum.spv" },
+                { "../examples/shaders/fibonacci.spv", 20 },
+                { "../examples/shaders/fibonacci.spv", 10 }
+            });
+            Task task = manager.createTask("../examples/shaders/fibonacci.spv", 20);
+
+            REQUIRE(tasks.size() == 4);
+            REQUIRE(tasks[0].getPipeline() != VK_NULL_HANDLE);
+            REQUIRE(tasks[0].getPipeline() == tasks[2].getPipeline());
+            REQUIRE(tasks[0].getPipeline() != tasks[3].getPipeline());
+            REQUIRE(tasks[0].getPipeline() != tasks[1].getPipeline());
+            REQUIRE(tasks[0].getPipeline() == task.getPipeline());
+            REQUIRE(tasks[1].getDescriptorSetLayoutsCount() == 1);
+            REQUIRE(tasks[1].getName() == "sum");
+        }
+
+        SECTION("with name")
+        {
+            TaskCreateInfo info("../examples/shaders/sum.spv");
+            info.name = "reduction";
+            REQUIRE(manager.createTasks({ info })[0].getName() == "reduction");
+        }
+
+        SECTION("with dynamic bindings")
+        {
+            TaskCreateInfo info("../examples/shaders/scale.spv");
+            REQUIRE(manager.createTasks({ info })[0].getResourceTypes()[0][0] == ResourceType::UniformBuffer);
+
+            info.dynamicBindings = { { 0, 0 }, { 0, 1 } };
+            Task task = manager.createTasks({ info })[0];
+            REQUIRE(task.getResourceTypes()[0][0] == ResourceType::UniformBufferDynamic);
+            REQUIRE(task.getResourceTypes()[0][1] == ResourceType::StorageBufferDynamic);
+
+            info.dynamicBindings = { { 0, 2 } };
+            REQUIRE_THROWS(manager.createTasks({ info }));
+        }
     }
 
     SECTION("ResourceSet created")
@@ -82,5 +240,213 @@ TEST_CASE("JobManager resource creation", "[JobManager]")
         ResourceSet set = manager.createResourceSet({ &buffer, &image });
         REQUIRE(set.getDescriptorSet() != VK_NULL_HANDLE);
     }
+
+    SECTION("ResourceSet created for the task")
+    {
+        TaskCreateInfo info("../examples/shaders/scale.spv");
+        info.dynamicBindings = { { 0, 0 } };
+        Task task = manager.createTasks({ info })[0];
+
+        size_t stride = manager.getComputeLimits().minUniformBufferOffsetAlignment;
+        Buffer params = manager.createBuffer(2 * stride, Buffer::Type::Uniform);
+        Buffer range(params, stride, sizeof(uint32_t));
+        Buffer values = manager.createBuffer(10);
+
+        ResourceSet set = manager.createResourceSet(task, 0, { &range, &values });
+        REQUIRE(set.getDescriptorSet() != VK_NULL_HANDLE);
+        REQUIRE(set.getDynamicOffsets() == std::vector<uint32_t>{ static_cast<uint32_t>(stride) });
+
+        // images can not be bound to the buffer bindings
+        Image image = manager.createImage(10, 10);
+        REQUIRE_THROWS(manager.createResourceSet(task, 0, { &range, &image }));
+    }
+
+    SECTION("Texel buffer view created")
+    {
+        Buffer buffer = manager.createBuffer(64);
+        TexelBufferView view = manager.createTexelBufferView(buffer, VK_FORMAT_R32_SFLOAT);
+
+        REQUIRE(view.getResourceType() == ResourceType::StorageTexelBuffer);
+        REQUIRE(view.getView() != VK_NULL_HANDLE);
+        REQUIRE(view.getBuffer() == buffer.getBuffer());
+        REQUIRE(view.getFormat() == VK_FORMAT_R32_SFLOAT);
+        REQUIRE(manager.createTexelBufferView(buffer, VK_FORMAT_R32_SFLOAT).getView() == view.getView());
+
+        ResourceSet set = manager.createResourceSet({ &view });
+        REQUIRE(set.getDescriptorSet() != VK_NULL_HANDLE);
+    }
+
+    SECTION("ResourceSets exceeding single descriptor pool")
+    {
+        Buffer buffer = manager.createBuffer(10);
+
+        std::set<VkDescriptorSet> descriptorSets;
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            ResourceSet set = manager.createResourceSet({ &buffer });
+            REQUIRE(set.getDescriptorSet() != VK_NULL_HANDLE);
+            descriptorSets.insert(set.getDescriptorSet());
+        }
+        REQUIRE(descriptorSets.size() == 1000);
+    }
+
+    SECTION("Resources released")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+        std::weak_ptr<const void> lifetime;
+
+        SECTION("after the job is reset")
+        {
+            Job job = manager.createJob();
+            {
+                Buffer buffer = manager.createBuffer(dataSize);
+                Buffer copy = buffer;
+                REQUIRE(copy.getLifetime() == buffer.getLifetime());
+                lifetime = buffer.getLifetime();
+
+                job.syncResourceToDevice(buffer, data, dataSize)
+                    .addTask(task, {{ &buffer }}, count)
+                    .submit();
+                REQUIRE(lifetime.use_count() == 3);
+            }
+            REQUIRE_FALSE(lifetime.expired());
+            REQUIRE(job.await());
+
+            job.reset();
+            REQUIRE(lifetime.expired());
+        }
+
+        SECTION("after the job is destroyed")
+        {
+            {
+                Job job = manager.createJob();
+                Buffer buffer = manager.createBuffer(dataSize);
+                lifetime = buffer.getLifetime();
+                job.syncResourceToDevice(buffer, data, dataSize).submit();
+                REQUIRE(job.await());
+            }
+            // returned with the other objects of the job once the manager reclaims them
+            REQUIRE_FALSE(lifetime.expired());
+            manager.createBuffer(dataSize);
+            REQUIRE(lifetime.expired());
+        }
+
+        SECTION("with their cached descriptor sets")
+        {
+            // more sets than a single pool holds
+            Job job = manager.createJob();
+            size_t poolCount = 0;
+            for (size_t i = 0; i < 1000; ++i)
+            {
+                Buffer buffer = manager.createBuffer(dataSize);
+                job.reset()
+                    .addTask(task, {{ &buffer }}, count)
+                    .submit();
+                REQUIRE(job.await());
+                if (i == 0)
+                    poolCount = manager.getCachedDescriptorPoolCount();
+            }
+            job.reset();
+            REQUIRE(poolCount == 1);
+            REQUIRE(manager.getCachedDescriptorPoolCount() == poolCount);
+        }
+    }
 }
 
+
+TEST_CASE("JobManager memory statistics", "[JobManager]")
+{
+    constexpr size_t MiB = 1024 * 1024;
+    auto usedMemory = [](JobManager &manager) {
+        VkDeviceSize used = 0;
+        for (const auto &heap : manager.getMemoryStatistics())
+            used += heap.usedBytes;
+        return used;
+    };
+
+    SECTION("Usage tracked")
+    {
+        JobManager manager;
+        auto statistics = manager.getMemoryStatistics();
+        REQUIRE(statistics.size() > 0);
+        for (const auto &heap : statistics)
+        {
+            REQUIRE(heap.size > 0);
+            REQUIRE(heap.budget > 0);
+            REQUIRE(heap.allocatedBytes >= heap.usedBytes);
+        }
+
+        VkDeviceSize used = usedMemory(manager);
+        {
+            Buffer buffer = manager.createBuffer(MiB, Buffer::Type::Staging);
+            REQUIRE(usedMemory(manager) >= used + MiB);
+        }
+        REQUIRE(usedMemory(manager) == used);
+    }
+
+    SECTION("Soft limit enforced")
+    {
+        JobManagerSettings settings;
+        settings.memorySoftLimit = 8 * MiB;
+        JobManager manager({}, nullptr, settings);
+
+        REQUIRE_THROWS(manager.createBuffer(16 * MiB, Buffer::Type::Staging));
+
+        {
+            Buffer buffer = manager.createBuffer(4 * MiB, Buffer::Type::Staging);
+            REQUIRE_THROWS(manager.createBuffer(5 * MiB, Buffer::Type::Staging));
+            REQUIRE_NOTHROW(manager.createBuffer(MiB, Buffer::Type::Staging));
+        }
+
+        // memory kept alive by the destroyed job is evicted instead of failing
+        {
+            Job job = manager.createJob();
+            Buffer deviceBuffer = manager.createBuffer(2 * MiB);
+            std::vector<uint32_t> data(2 * MiB / sizeof(uint32_t), 1);
+            job.syncResourceToDevice(deviceBuffer, data.data(), 2 * MiB).submit();
+        }
+        REQUIRE_NOTHROW(manager.createBuffer(6 * MiB, Buffer::Type::Staging));
+    }
+}
+
+TEST_CASE("JobManager pipeline cache", "[JobManager]")
+{
+    JobManagerSettings settings;
+    settings.pipelineCachePath = "pipeline_cache_test.bin";
+    std::remove(settings.pipelineCachePath.c_str());
+
+    SECTION("Saved and loaded")
+    {
+        {
+            JobManager manager({}, nullptr, settings);
+            Task task = manager.createTask("../examples/shaders/fibonacci.spv", 20);
+        }
+
+        std::ifstream ifs(settings.pipelineCachePath, std::ios::binary | std::ios::ate);
+        REQUIRE(ifs.is_open());
+        REQUIRE(ifs.tellg() >= 32);
+        ifs.close();
+
+        JobManager manager({}, nullptr, settings);
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", 20);
+        REQUIRE(task.getPipeline() != VK_NULL_HANDLE);
+    }
+
+    SECTION("Incompatible cache ignored")
+    {
+        {
+            std::ofstream ofs(settings.pipelineCachePath, std::ios::binary);
+            std::vector<char> garbage(64, 7);
+            ofs.write(garbage.data(), garbage.size());
+        }
+
+        JobManager manager({}, nullptr, settings);
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", 20);
+        REQUIRE(task.getPipeline() != VK_NULL_HANDLE);
+    }
+
+    std::remove(settings.pipelineCachePath.c_str());
+}
@@ -7,6 +7,10 @@
 
 #include "TestUtils.h"
 
+#include <cstring>
+#include <sstream>
+#include <thread>
+
 
 TEST_CASE("Job transfer tests", "[Job]")
 {
@@ -24,7 +28,8 @@ TEST_CASE("Job transfer tests", "[Job]")
 
         SECTION("To/from device")
         {
-            auto bufferType = GENERATE(Buffer::Type::DeviceLocal, Buffer::Type::Staging, Buffer::Type::Uniform);
+            auto bufferType = GENERATE(Buffer::Type::DeviceLocal, Buffer::Type::Staging, Buffer::Type::Uniform,
+                Buffer::Type::DeviceMapped);
             SECTION(bufferTypeName(bufferType))
             {
                 buffer1 = manager.createBuffer(dataSize, bufferType);
@@ -33,6 +38,19 @@ TEST_CASE("Job transfer tests", "[Job]")
             }
         }
 
+        SECTION("Through mapped memory")
+        {
+            auto bufferType = GENERATE(Buffer::Type::DeviceLocal, Buffer::Type::Staging);
+            SECTION(bufferTypeName(bufferType))
+            {
+                buffer1 = manager.createBuffer(dataSize, bufferType);
+                Buffer *hostVisible = bufferType == Buffer::Type::DeviceLocal ? buffer1.getStagingBuffer() : &buffer1;
+                std::memcpy(hostVisible->data(), data, dataSize);
+                job.syncResourceToDevice(buffer1, hostVisible->data(), dataSize);
+                job.syncResourceToHost(buffer1, result, dataSize);
+            }
+        }
+
         SECTION("Between buffers")
         {
             auto bufferType1 = GENERATE(Buffer::Type::DeviceLocal, Buffer::Type::Staging);
@@ -64,6 +82,7 @@ TEST_CASE("Job transfer tests", "[Job]")
         stbi_uc* result = new stbi_uc[texWidth * texHeight * 4];
         Image image = manager.createImage(texWidth, texHeight);
         Image image2;
+        Image image3;
 
         job.syncResourceToDevice(image, pixels, image.getSize());
         
@@ -79,6 +98,16 @@ TEST_CASE("Job transfer tests", "[Job]")
             job.syncResourceToHost(image2, result, image2.getSize());
         }
 
+        SECTION("Chain of images")
+        {
+            // layout transitions between the copies are merged into single barriers
+            image2 = manager.createImage(texWidth, texHeight);
+            image3 = manager.createImage(texWidth, texHeight);
+            job.syncResources(image, image2);
+            job.syncResources(image2, image3);
+            job.syncResourceToHost(image3, result, image3.getSize());
+        }
+
         job.submit();
         REQUIRE(job.await());
 
@@ -87,6 +116,34 @@ TEST_CASE("Job transfer tests", "[Job]")
         stbi_image_free(pixels);
         delete[] result;
     }
+
+    SECTION("Image with mip levels and array layers transfer")
+    {
+        ImageCreateInfo info{ 7, 5, VK_FORMAT_R8_UNORM, 3, 2 };
+        Image image = manager.createImage(info);
+        Image image2 = manager.createImage(info);
+        SampledImage sampled = manager.createSampledImage(image2, VK_FILTER_NEAREST);
+
+        std::vector<uint8_t> data(image.getSize());
+        std::vector<uint8_t> result(image.getSize());
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<uint8_t>(i);
+
+        // sampled image shares the layout of the image it was created from
+        job.syncResourceToDevice(image, data.data(), data.size())
+            .syncResources(image, image2)
+            .syncResourceToHost(sampled, result.data(), result.size())
+            .submit();
+        REQUIRE(job.await());
+
+        // padding between the mip levels is not copied
+        for (uint32_t level = 0; level < image.getMipLevels(); ++level)
+        {
+            size_t offset = image.getMipLevelOffset(level);
+            REQUIRE(std::equal(data.begin() + offset, data.begin() + offset + image.getMipLevelSize(level),
+                result.begin() + offset));
+        }
+    }
 }
 
 TEST_CASE("Job execute tests", "[Job]")
@@ -190,6 +247,523 @@ TEST_CASE("Job execute tests", "[Job]")
         }
     }
 
+    SECTION("Multiple submit with new host data")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        constexpr size_t iterations = 3;
+        Buffer buffer = manager.createBuffer(dataSize);
+        Buffer constants = manager.createBuffer(dataSize, Buffer::Type::Uniform);
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+
+        uint32_t inData[iterations][count] = {{1, 2, 3, 4, 5}, {5, 4, 3, 2, 1}, {2, 2, 2, 2, 2}};
+        uint32_t expectedData[iterations][count] = {{1, 1, 2, 3, 5}, {5, 3, 2, 1, 1}, {1, 1, 1, 1, 1}};
+        uint32_t outData[iterations][count];
+
+        REQUIRE_THROWS(job.setUploadData(buffer, inData[0]));
+
+        job.syncResourceToDevice(buffer, inData[0], dataSize)
+            .syncResourceToDevice(constants, inData[0], dataSize)
+            .addTask(task, {{ &buffer }}, count)
+            .syncResourceToHost(buffer, outData[0], dataSize);
+
+        REQUIRE_THROWS(job.setReadbackData(constants, outData[0]));
+
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            job.setUploadData(buffer, inData[i])
+                .setUploadData(constants, inData[i])
+                .setReadbackData(buffer, outData[i])
+                .submit();
+            REQUIRE_THROWS(job.setUploadData(buffer, inData[0]));
+            REQUIRE(job.await());
+            REQUIRE(std::equal(outData[i], outData[i] + count, expectedData[i]));
+            const uint32_t *mapped = static_cast<const uint32_t*>(constants.data());
+            REQUIRE(std::equal(mapped, mapped + count, inData[i]));
+        }
+    }
+
+    SECTION("Reset")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        Buffer buffer = manager.createBuffer(dataSize);
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t result[count];
+        uint32_t expected[count] = {1, 1, 2, 3, 5};
+
+        job.syncResourceToDevice(buffer, data, dataSize)
+            .syncResourceToHost(buffer, result, dataSize)
+            .submit();
+        REQUIRE_THROWS(job.reset());
+        REQUIRE(job.await());
+        REQUIRE(std::equal(data, data + count, result));
+
+        VkCommandBuffer commandBuffer = job.getCommandBuffer();
+        job.reset()
+            .syncResourceToDevice(buffer, data, dataSize)
+            .addTask(task, {{ &buffer }}, count)
+            .syncResourceToHost(buffer, result, dataSize)
+            .submit();
+        REQUIRE(job.await());
+
+        REQUIRE(job.getCommandBuffer() == commandBuffer);
+        REQUIRE(std::equal(result, result + count, expected));
+    }
+
+    SECTION("Repeated resource bindings")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        Buffer buffer = manager.createBuffer(dataSize);
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t expected[count] = {1, 1, 2, 3, 5};
+
+        job.syncResourceToDevice(buffer, data, dataSize);
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            job.addTask(task, {{ &buffer }}, count)
+                .waitForTasksFinish();
+        }
+        job.syncResourceToHost(buffer, data, dataSize)
+            .submit();
+        REQUIRE(job.await());
+        REQUIRE(std::equal(data, data + count, expected));
+
+        manager.clearDescriptorSetCache();
+        std::fill(data, data + count, 0);
+        job.reset()
+            .syncResourceToDevice(buffer, data, dataSize)
+            .addTask(task, {{ &buffer }}, count)
+            .syncResourceToHost(buffer, data, dataSize)
+            .submit();
+        REQUIRE(job.await());
+        REQUIRE(std::equal(data, data + count, expected));
+    }
+
+    SECTION("Batched submit")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        constexpr size_t jobCount = 16;
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+
+        uint32_t data[jobCount][count];
+        uint32_t expected[count] = {1, 1, 2, 3, 5};
+        std::vector<Buffer> buffers;
+        std::vector<Job> jobs;
+        std::vector<Job *> batch;
+        for (size_t i = 0; i < jobCount; ++i)
+        {
+            std::fill(data[i], data[i] + count, 0);
+            buffers.push_back(manager.createBuffer(dataSize));
+            jobs.push_back(manager.createJob());
+        }
+        for (size_t i = 0; i < jobCount; ++i)
+        {
+            jobs[i].syncResourceToDevice(buffers[i], data[i], dataSize)
+                .addTask(task, {{ &buffers[i] }}, count)
+                .syncResourceToHost(buffers[i], data[i], dataSize);
+            batch.push_back(&jobs[i]);
+        }
+
+        // rejected batches leave all jobs unsubmitted
+        Job secondary = manager.createSecondaryJob();
+        REQUIRE_THROWS(manager.submit({ &jobs[0], &jobs[1], &jobs[0] }));
+        REQUIRE_THROWS(manager.submit({ &jobs[0], &secondary }));
+        if (manager.supportsTimelineSemaphores())
+        {
+            Job dependent = manager.createJob();
+            dependent.dependsOn(jobs[1]);
+            REQUIRE_THROWS(manager.submit({ &jobs[0], &dependent, &jobs[1] }));
+        }
+
+        for (size_t iteration = 0; iteration < 2; ++iteration)
+        {
+            manager.submit(batch);
+            REQUIRE_THROWS(manager.submit({ &jobs[0] }));
+            for (size_t i = 0; i < jobCount; ++i)
+            {
+                REQUIRE(jobs[i].await());
+                REQUIRE(std::equal(data[i], data[i] + count, expected));
+                std::fill(data[i], data[i] + count, 0);
+            }
+        }
+
+        jobs[0].submit();
+        REQUIRE(jobs[0].await());
+        REQUIRE(std::equal(data[0], data[0] + count, expected));
+    }
+
+    SECTION("Transient buffers")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        Task fibonacci = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+        Task sum = manager.createTask("../examples/shaders/sum.spv", (uint32_t)count);
+        Buffer input = manager.createBuffer(dataSize);
+        Buffer output = manager.createBuffer(dataSize);
+
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t result[count];
+        uint32_t expected[count] = {2, 3, 5, 7, 10};
+
+        Buffer scratch1 = job.createTransientBuffer(dataSize);
+        Buffer scratch2 = job.createTransientBuffer(dataSize);
+        REQUIRE(scratch1.getBuffer() == scratch2.getBuffer());
+        REQUIRE(scratch1.getOffset() != scratch2.getOffset());
+        REQUIRE_THROWS(job.releaseTransientBuffer(input));
+
+        job.syncResourceToDevice(input, data, dataSize)
+            .syncResources(input, scratch1)
+            .addTask(fibonacci, {{ &scratch1 }}, count)
+            .syncResources(scratch1, output)
+            .releaseTransientBuffer(scratch1);
+
+        Buffer scratch3 = job.createTransientBuffer(dataSize);
+        REQUIRE(scratch3.getBuffer() == scratch1.getBuffer());
+        REQUIRE(scratch3.getOffset() == scratch1.getOffset());
+
+        job.syncResources(input, scratch3)
+            .addTask(sum, {{ &scratch3, &output }}, count)
+            .syncResourceToHost(output, result, dataSize)
+            .submit();
+        REQUIRE(job.await());
+        REQUIRE(std::equal(result, result + count, expected));
+
+        job.reset();
+        REQUIRE(job.createTransientBuffer(dataSize).getOffset() == 0);
+    }
+
+    SECTION("Partial transfers")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+        Buffer buffer = manager.createBuffer(dataSize);
+
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t patch[2] = {7, 8};
+        uint32_t result[count];
+        uint32_t expected[count] = {7, 8, 2, 3, 5};
+
+        // the second upload overlaps only with the part of the buffer written by the task
+        job.syncResourceToDevice(buffer, data, dataSize)
+            .addTask(task, {{ &buffer }}, count)
+            .syncResourceToDevice(buffer, patch, sizeof(patch))
+            .syncResourceToHost(buffer, result, dataSize)
+            .submit();
+        REQUIRE(job.await());
+
+        REQUIRE(std::equal(result, result + count, expected));
+    }
+
+    SECTION("Buffer views and transfers with offsets")
+    {
+        constexpr size_t count = 5;
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+
+        // view bound to the task has to start at the aligned offset
+        size_t first = std::max<size_t>(count, manager.getComputeLimits().minStorageBufferOffsetAlignment / sizeof(uint32_t));
+        size_t total = first + count;
+        Buffer buffer = manager.createBuffer(total * sizeof(uint32_t));
+        BufferView<uint32_t> view(buffer, first, count);
+
+        std::vector<uint32_t> data(total, 4);
+        std::vector<uint32_t> result(total);
+        uint32_t patch[count] = {1, 2, 3, 4, 5};
+        uint32_t patchResult[2];
+
+        job.syncResourceToDevice(buffer, data.data(), total * sizeof(uint32_t))
+            .syncResourceToDevice(view, patch, sizeof(patch))
+            .addTask(task, { { &view } }, count)
+            .syncResourceToHost(buffer, result.data(), total * sizeof(uint32_t))
+            .syncResourceToHost(buffer, patchResult, sizeof(patchResult), (first + 3) * sizeof(uint32_t))
+            .submit();
+        REQUIRE(job.await());
+
+        std::vector<uint32_t> expected(total, 4);
+        uint32_t fibonacci[count] = {1, 1, 2, 3, 5};
+        std::copy(fibonacci, fibonacci + count, expected.begin() + first);
+        REQUIRE(result == expected);
+        REQUIRE(patchResult[0] == 3);
+        REQUIRE(patchResult[1] == 5);
+
+        REQUIRE_THROWS(job.reset().syncResourceToDevice(buffer, patch, sizeof(patch), (total + 1) * sizeof(uint32_t)));
+    }
+
+    SECTION("Reads of different parts of one write")
+    {
+        // both halves are read by the same stage after the task wrote the whole buffer
+        size_t half = std::max<size_t>(4, manager.getComputeLimits().minStorageBufferOffsetAlignment / sizeof(uint32_t));
+        size_t halfSize = half * sizeof(uint32_t);
+        Task fibonacciTask = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)(2 * half));
+        Task sumTask = manager.createTask("../examples/shaders/sum.spv");
+        Buffer values = manager.createBuffer(2 * halfSize);
+        Buffer first(values, 0, halfSize);
+        Buffer second(values, halfSize, halfSize);
+        Buffer firstSums = manager.createBuffer(halfSize);
+        Buffer secondSums = manager.createBuffer(halfSize);
+
+        std::vector<uint32_t> data(2 * half);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<uint32_t>(i % 6);
+        std::vector<uint32_t> zeros(half, 0);
+        std::vector<uint32_t> result(2 * half);
+
+        job.syncResourceToDevice(values, data.data(), 2 * halfSize)
+            .syncResourceToDevice(firstSums, zeros.data(), halfSize)
+            .syncResourceToDevice(secondSums, zeros.data(), halfSize)
+            .addTask(fibonacciTask, { { &values } }, (uint32_t)(2 * half))
+            .addTask(sumTask, { { &first, &firstSums } }, (uint32_t)half)
+            .addTask(sumTask, { { &second, &secondSums } }, (uint32_t)half)
+            .syncResourceToHost(firstSums, result.data(), halfSize)
+            .syncResourceToHost(secondSums, result.data() + half, halfSize)
+            .submit();
+        REQUIRE(job.await());
+
+        uint32_t fibonacci[6] = {0, 1, 1, 2, 3, 5};
+        std::vector<uint32_t> expected(2 * half);
+        for (size_t i = 0; i < expected.size(); ++i)
+            expected[i] = fibonacci[data[i]];
+        REQUIRE(result == expected);
+    }
+
+    SECTION("Uniform and dynamic uniform buffers")
+    {
+        constexpr size_t count = 4;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        size_t stride = manager.getComputeLimits().minUniformBufferOffsetAlignment;
+
+        // one parameter buffer with a factor per dispatch
+        Buffer params = manager.createBuffer(3 * stride, Buffer::Type::Uniform);
+        std::vector<Buffer> ranges;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            *reinterpret_cast<uint32_t *>(static_cast<char *>(params.data()) + i * stride) = static_cast<uint32_t>(i + 2);
+            ranges.emplace_back(params, i * stride, sizeof(uint32_t));
+        }
+        Buffer values = manager.createBuffer(dataSize);
+        uint32_t data[count] = {1, 2, 3, 4};
+
+        TaskCreateInfo info("../examples/shaders/scale.spv");
+        uint32_t expected[count];
+        SECTION("Uniform buffer")
+        {
+            Task task = manager.createTasks({ info })[0];
+            job.syncResourceToDevice(values, data, dataSize)
+                .addTask(task, { { &ranges[1], &values } }, count);
+            std::transform(data, data + count, expected, [](uint32_t value) { return value * 3; });
+        }
+        SECTION("Dynamic uniform buffer")
+        {
+            info.dynamicBindings = { { 0, 0 } };
+            Task task = manager.createTasks({ info })[0];
+            job.syncResourceToDevice(values, data, dataSize);
+            for (auto &range : ranges)
+                job.addTask(task, { { &range, &values } }, count);
+            std::transform(data, data + count, expected, [](uint32_t value) { return value * 2 * 3 * 4; });
+        }
+
+        job.syncResourceToHost(values, data, dataSize)
+            .submit();
+        REQUIRE(job.await());
+        REQUIRE(std::equal(data, data + count, expected));
+    }
+
+    SECTION("Range dispatch")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+        Buffer buffer = manager.createBuffer(dataSize);
+
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t expected[count] = {1, 1, 2, 3, 5};
+
+        job.syncResourceToDevice(buffer, data, dataSize)
+            .addTaskRange(task, {{ &buffer }}, count)
+            .syncResourceToHost(buffer, data, dataSize)
+            .submit();
+        REQUIRE(job.await());
+
+        REQUIRE(std::equal(data, data + count, expected));
+    }
+
+    SECTION("Range dispatch split")
+    {
+        using Groups = std::array<uint32_t, 3>;
+        std::vector<std::pair<Groups, Groups>> parts;
+        auto collect = [&parts](const Groups &base, const Groups &groupCount) {
+            parts.emplace_back(base, groupCount);
+        };
+
+        Job::splitDispatch({ 5, 3, 1 }, { 2, 2, 2 }, collect);
+        REQUIRE(parts.size() == 6);
+        REQUIRE(parts[0] == std::make_pair(Groups{ 0, 0, 0 }, Groups{ 2, 2, 1 }));
+        REQUIRE(parts[2] == std::make_pair(Groups{ 4, 0, 0 }, Groups{ 1, 2, 1 }));
+        REQUIRE(parts[5] == std::make_pair(Groups{ 4, 2, 0 }, Groups{ 1, 1, 1 }));
+
+        // last part starts close to the end of the 32-bit range
+        parts.clear();
+        Job::splitDispatch({ UINT32_MAX, 1, 1 }, { (1u << 31) - 1, 65535, 65535 }, collect);
+        REQUIRE(parts.size() == 3);
+        REQUIRE(parts[2] == std::make_pair(Groups{ UINT32_MAX - 1, 0, 0 }, Groups{ 1, 1, 1 }));
+    }
+
+    SECTION("Indirect dispatch")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+        Buffer buffer = manager.createBuffer(dataSize);
+        Buffer args = manager.createBuffer(2 * sizeof(VkDispatchIndirectCommand));
+
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t expected[count] = {1, 1, 2, 3, 5};
+        VkDispatchIndirectCommand commands[2] = { { 0, 0, 0 }, { (uint32_t)count, 1, 1 } };
+
+        REQUIRE_THROWS(job.addTaskIndirect(task, args, 2));
+        REQUIRE_THROWS(job.addTaskIndirect(task, args, 2 * sizeof(VkDispatchIndirectCommand)));
+
+        job.syncResourceToDevice(buffer, data, dataSize)
+            .syncResourceToDevice(args, commands, sizeof(commands))
+            .useResources(0, { &buffer })
+            .addTaskIndirect(task, args, sizeof(VkDispatchIndirectCommand))
+            .syncResourceToHost(buffer, data, dataSize)
+            .submit();
+        REQUIRE(job.await());
+
+        REQUIRE(std::equal(data, data + count, expected));
+    }
+
+    SECTION("Asynchronous submit")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+        Buffer buffer = manager.createBuffer(dataSize);
+
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t expected[count] = {1, 1, 2, 3, 5};
+        uint32_t callbackData[count] = {};
+
+        job.syncResourceToDevice(buffer, data, dataSize)
+            .addTask(task, { { &buffer } }, count)
+            .syncResourceToHost(buffer, data, dataSize);
+
+        Job *completedJob = nullptr;
+        auto future = job.submitAsync([&](Job &completed) {
+            completedJob = &completed;
+            // readbacks are completed before the callback
+            std::copy(data, data + count, callbackData);
+        });
+        future.get();
+
+        REQUIRE(completedJob == &job);
+        REQUIRE(std::equal(callbackData, callbackData + count, expected));
+
+        // job is no longer submitted, so it can be resubmitted right away
+        uint32_t input[count] = {1, 2, 3, 4, 5};
+        job.setUploadData(buffer, input);
+        REQUIRE_NOTHROW(job.submitAsync().get());
+        REQUIRE(std::equal(data, data + count, expected));
+
+        auto failing = job.submitAsync([](Job &) {
+            throw std::runtime_error("Callback failed");
+        });
+        REQUIRE_THROWS(failing.get());
+    }
+
+    SECTION("Jobs recorded on different threads")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        constexpr size_t threadCount = 4;
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+
+        std::vector<std::vector<uint32_t>> data(threadCount, std::vector<uint32_t>{1, 2, 3, 4, 5});
+        uint32_t expected[count] = {1, 1, 2, 3, 5};
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            threads.emplace_back([&, i]() {
+                Buffer buffer = manager.createBuffer(dataSize);
+                Job threadJob = manager.createJob();
+                threadJob.syncResourceToDevice(buffer, data[i].data(), dataSize)
+                    .addTask(task, { { &buffer } }, count)
+                    .syncResourceToHost(buffer, data[i].data(), dataSize)
+                    .submit();
+                threadJob.await();
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        for (const auto &result : data)
+            REQUIRE(std::equal(result.begin(), result.end(), expected));
+    }
+
+    SECTION("Secondary jobs")
+    {
+        constexpr size_t count = 5;
+        constexpr size_t dataSize = count * sizeof(uint32_t);
+        constexpr size_t partCount = 3;
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+
+        std::vector<Buffer> buffers;
+        std::vector<Job> parts;
+        for (size_t i = 0; i < partCount; ++i)
+        {
+            buffers.push_back(manager.createBuffer(dataSize));
+            parts.push_back(manager.createSecondaryJob());
+        }
+
+        std::vector<std::vector<uint32_t>> data(partCount, std::vector<uint32_t>{1, 2, 3, 4, 5});
+        uint32_t expected[count] = {1, 1, 2, 3, 5};
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < partCount; ++i)
+        {
+            threads.emplace_back([&, i]() {
+                parts[i].syncResourceToDevice(buffers[i], data[i].data(), dataSize)
+                    .addTask(task, { { &buffers[i] } }, count)
+                    .syncResourceToHost(buffers[i], data[i].data(), dataSize);
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        REQUIRE_THROWS(parts[0].submit());
+
+        std::vector<Job *> partPointers;
+        for (auto &part : parts)
+            partPointers.push_back(&part);
+        job.executeSecondaryJobs(partPointers).submit();
+        REQUIRE(job.await());
+
+        for (const auto &result : data)
+            REQUIRE(std::equal(result.begin(), result.end(), expected));
+
+        REQUIRE_THROWS(job.executeSecondaryJobs({ &parts[0] }));
+
+        // images have to be in the general layout already
+        Image image = manager.createImage(4, 4);
+        std::vector<uint8_t> imageData(image.getSize());
+        Job imagePart = manager.createSecondaryJob();
+        REQUIRE_THROWS(imagePart.syncResourceToDevice(image, imageData.data(), imageData.size()));
+        job.reset()
+            .syncResourceToDevice(image, nullptr)
+            .submit();
+        REQUIRE(job.await());
+        REQUIRE_NOTHROW(imagePart.syncResourceToDevice(image, nullptr));
+    }
+
     SECTION("Multiple task invokations")
     {
         constexpr size_t count = 5;
@@ -219,3 +793,455 @@ TEST_CASE("Job execute tests", "[Job]")
         REQUIRE(std::equal(data2, data2 + count, expected2));
     }
 }
+
+TEST_CASE("Job dependency tests", "[Job]")
+{
+    JobManager manager;
+    if (!manager.supportsTimelineSemaphores())
+    {
+        Job job = manager.createJob();
+        Job other = manager.createJob();
+        REQUIRE_THROWS(job.dependsOn(other));
+        return;
+    }
+
+    constexpr size_t count = 5;
+    constexpr size_t dataSize = count * sizeof(uint32_t);
+    Buffer buffer1 = manager.createBuffer(dataSize);
+    Buffer buffer2 = manager.createBuffer(dataSize);
+    Task task = manager.createTask("../examples/shaders/sum.spv", (uint32_t)count);
+
+    uint32_t data1[count] = {1, 2, 3, 4, 5};
+    uint32_t data2[count] = {10, 20, 30, 40, 50};
+    uint32_t result[count];
+
+    Job uploadJob = manager.createJob();
+    Job computeJob = manager.createJob();
+    Job readbackJob = manager.createJob();
+    uploadJob.syncResourceToDevice(buffer1, data1)
+        .syncResourceToDevice(buffer2, data2);
+    computeJob.addTask(task, {{ &buffer1, &buffer2 }}, count)
+        .dependsOn(uploadJob, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    readbackJob.syncResourceToHost(buffer2, result)
+        .dependsOn(computeJob, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    SECTION("Chain of jobs")
+    {
+        uint32_t expected[count] = {11, 22, 33, 44, 55};
+
+        uploadJob.submit();
+        computeJob.submit();
+        readbackJob.submit();
+        REQUIRE(readbackJob.await());
+        REQUIRE(computeJob.await());
+        REQUIRE(uploadJob.await());
+
+        REQUIRE(std::equal(result, result + count, expected));
+    }
+
+    SECTION("Resubmission and timeline values")
+    {
+        uploadJob.submit();
+        uint64_t firstValue = uploadJob.getTimelineValue();
+        REQUIRE(uploadJob.wait(firstValue));
+        REQUIRE(uploadJob.await());
+
+        uint32_t expected[count] = {11, 22, 33, 44, 55};
+        for (size_t i = 0; i < 3; ++i)
+        {
+            uploadJob.submit();
+            computeJob.submit();
+            readbackJob.submit();
+            REQUIRE(readbackJob.await());
+            REQUIRE(computeJob.await());
+            REQUIRE(uploadJob.await());
+            REQUIRE(std::equal(result, result + count, expected));
+        }
+        REQUIRE(uploadJob.getTimelineValue() == firstValue + 3);
+    }
+
+    SECTION("Dependency that was not submitted")
+    {
+        REQUIRE_THROWS(computeJob.submit());
+    }
+}
+
+TEST_CASE("Job dedicated transfer queue tests", "[Job]")
+{
+    JobManagerSettings settings;
+    settings.useDedicatedTransferQueue = true;
+    JobManager manager({}, nullptr, settings);
+    Job job = manager.createJob();
+
+    constexpr size_t count = 5;
+    constexpr size_t dataSize = count * sizeof(uint32_t);
+    Buffer buffer = manager.createBuffer(dataSize);
+
+    SECTION("To/from device")
+    {
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t result[count];
+
+        job.syncResourceToDevice(buffer, data, dataSize)
+            .syncResourceToHost(buffer, result, dataSize)
+            .submit();
+        REQUIRE(job.await());
+
+        REQUIRE(std::equal(data, data + count, result));
+    }
+
+    SECTION("Transfers around the task")
+    {
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t expected[count] = {1, 1, 2, 3, 5};
+
+        job.syncResourceToDevice(buffer, data, dataSize)
+            .addTask(task, {{ &buffer }}, count)
+            .syncResourceToHost(buffer, data, dataSize);
+
+        for (size_t i = 0; i < 2; ++i)
+        {
+            for (size_t n = 0; n < count; ++n)
+                data[n] = static_cast<uint32_t>(n + 1);
+            job.submit();
+            REQUIRE(job.await());
+            REQUIRE(std::equal(data, data + count, expected));
+        }
+    }
+
+    SECTION("Batched submit")
+    {
+        Buffer buffer2 = manager.createBuffer(dataSize);
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t result[count];
+        uint32_t result2[count];
+
+        Job uploadJob = manager.createJob();
+        job.syncResourceToDevice(buffer, data, dataSize)
+            .syncResourceToHost(buffer, result, dataSize);
+        uploadJob.syncResourceToDevice(buffer2, data, dataSize);
+
+        manager.submit({ &job, &uploadJob });
+        REQUIRE(job.await());
+        REQUIRE(uploadJob.await());
+        REQUIRE(std::equal(data, data + count, result));
+
+        Job readbackJob = manager.createJob();
+        readbackJob.syncResourceToHost(buffer2, result2, dataSize);
+        manager.submit({ &readbackJob });
+        REQUIRE(readbackJob.await());
+        REQUIRE(std::equal(data, data + count, result2));
+    }
+
+    SECTION("Write after readback")
+    {
+        Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t result[count];
+
+        job.syncResourceToDevice(buffer, data, dataSize)
+            .syncResourceToHost(buffer, result, dataSize);
+        if (manager.hasDedicatedTransferQueue())
+        {
+            // readback is executed only after all compute commands of the job
+            REQUIRE_THROWS(job.addTask(task, {{ &buffer }}, count));
+        }
+        else
+        {
+            // readback on the compute queue is ordered before the later write
+            REQUIRE_NOTHROW(job.addTask(task, {{ &buffer }}, count));
+            job.submit();
+            REQUIRE(job.await());
+            REQUIRE(std::equal(data, data + count, result));
+        }
+    }
+
+    SECTION("Dedicated queue only when requested")
+    {
+        // transfers of the default manager are recorded on the compute queue
+        JobManager defaultManager;
+        REQUIRE_FALSE(defaultManager.hasDedicatedTransferQueue());
+    }
+}
+
+TEST_CASE("Job shared staging buffer tests", "[Job]")
+{
+    JobManagerSettings settings;
+    settings.stagingBufferSize = 1024;
+    JobManager manager({}, nullptr, settings);
+
+    constexpr size_t count = 5;
+    constexpr size_t dataSize = count * sizeof(uint32_t);
+    Buffer buffer = manager.createBuffer(dataSize);
+    REQUIRE(buffer.getStagingBuffer() == nullptr);
+
+    SECTION("To/from device")
+    {
+        Job job = manager.createJob();
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t result[count];
+
+        job.syncResourceToDevice(buffer, data, dataSize)
+            .syncResourceToHost(buffer, result, dataSize)
+            .submit();
+        REQUIRE(job.await());
+
+        REQUIRE(std::equal(data, data + count, result));
+    }
+
+    SECTION("Multiple jobs")
+    {
+        constexpr size_t jobCount = 8;
+        std::vector<Job> jobs;
+        uint32_t data[jobCount][count];
+        uint32_t result[jobCount][count];
+
+        for (size_t i = 0; i < jobCount; ++i)
+        {
+            for (size_t n = 0; n < count; ++n)
+                data[i][n] = static_cast<uint32_t>(i * count + n);
+
+            jobs.push_back(manager.createJob());
+            jobs.back().syncResourceToDevice(buffer, data[i], dataSize)
+                .syncResourceToHost(buffer, result[i], dataSize);
+        }
+
+        for (size_t i = 0; i < jobCount; ++i)
+        {
+            size_t index = jobCount - i - 1;
+            jobs[index].submit();
+            REQUIRE(jobs[index].await());
+            REQUIRE(std::equal(data[index], data[index] + count, result[index]));
+        }
+
+        std::fill(result[0], result[0] + count, 0);
+        jobs[0].submit();
+        REQUIRE(jobs[0].await());
+        REQUIRE(std::equal(data[0], data[0] + count, result[0]));
+    }
+
+    SECTION("Overlap with busy regions")
+    {
+        // single transfer occupies the whole staging buffer
+        Buffer largeBuffer = manager.createBuffer(settings.stagingBufferSize);
+        std::vector<uint32_t> largeData(settings.stagingBufferSize / sizeof(uint32_t), 7);
+        std::vector<uint32_t> largeResult(largeData.size());
+        uint32_t data[count] = {1, 2, 3, 4, 5};
+        uint32_t result[count];
+        Job first = manager.createJob();
+        Job second = manager.createJob();
+
+        SECTION("Upload of the finished job is reused")
+        {
+            first.syncResourceToDevice(largeBuffer, largeData.data())
+                .submit();
+            second.syncResourceToDevice(buffer, data, dataSize)
+                .syncResourceToHost(buffer, result, dataSize)
+                .submit();
+            REQUIRE(second.await());
+            REQUIRE(first.await());
+            REQUIRE(std::equal(data, data + count, result));
+        }
+
+        SECTION("Batch that does not fit")
+        {
+            first.syncResourceToDevice(largeBuffer, largeData.data());
+            second.syncResourceToDevice(buffer, data, dataSize)
+                .syncResourceToHost(buffer, result, dataSize);
+            REQUIRE_THROWS(manager.submit({ &first, &second }));
+
+            // jobs of the rejected batch can be submitted separately
+            first.submit();
+            REQUIRE(first.await());
+            second.submit();
+            REQUIRE(second.await());
+            REQUIRE(std::equal(data, data + count, result));
+        }
+
+        SECTION("Readback of the batched job that was not awaited")
+        {
+            Buffer buffer2 = manager.createBuffer(dataSize);
+            uint32_t data2[count] = {10, 20, 30, 40, 50};
+            uint32_t result2[count];
+            first.syncResourceToDevice(buffer, data, dataSize)
+                .syncResourceToHost(buffer, result, dataSize);
+            second.syncResourceToDevice(buffer2, data2, dataSize)
+                .syncResourceToHost(buffer2, result2, dataSize);
+            manager.submit({ &first, &second });
+            REQUIRE(first.await());
+            REQUIRE(std::equal(data, data + count, result));
+
+            // awaiting the first job keeps the readback of the second one busy
+            Job third = manager.createJob();
+            third.syncResourceToDevice(largeBuffer, largeData.data());
+            REQUIRE_THROWS(third.submit());
+            REQUIRE(second.await());
+            REQUIRE(std::equal(data2, data2 + count, result2));
+
+            third.reset()
+                .syncResourceToDevice(largeBuffer, largeData.data())
+                .submit();
+            REQUIRE(third.await());
+        }
+
+        SECTION("Readback of the job that was not awaited")
+        {
+            first.syncResourceToDevice(largeBuffer, largeData.data())
+                .submit();
+            REQUIRE(first.await());
+            first.reset();
+            first.syncResourceToHost(largeBuffer, largeResult.data())
+                .submit();
+            second.syncResourceToDevice(buffer, data, dataSize);
+            REQUIRE_THROWS(second.submit());
+
+            // already prepared jobs of the batch are rolled back
+            Job third = manager.createJob();
+            REQUIRE_THROWS(manager.submit({ &third, &second }));
+            third.submit();
+            REQUIRE(third.await());
+
+            // readback is not overwritten
+            REQUIRE(first.await());
+            REQUIRE(largeResult == largeData);
+            second.reset();
+            second.syncResourceToDevice(buffer, data, dataSize)
+                .syncResourceToHost(buffer, result, dataSize)
+                .submit();
+            REQUIRE(second.await());
+            REQUIRE(std::equal(data, data + count, result));
+        }
+    }
+
+    SECTION("Transfer larger than staging buffer")
+    {
+        Job job = manager.createJob();
+        Buffer largeBuffer = manager.createBuffer(2 * settings.stagingBufferSize);
+
+        REQUIRE_THROWS(job.syncResourceToDevice(largeBuffer, nullptr));
+    }
+}
+
+
+TEST_CASE("Job profiling tests", "[Job]")
+{
+    JobManagerSettings settings;
+    settings.enableProfiling = true;
+    settings.enablePipelineStatistics = true;
+    settings.enableDebugLabels = true;
+    JobManager manager({}, nullptr, settings);
+    if (!manager.isProfilingEnabled())
+        return;
+
+    constexpr size_t count = 5;
+    constexpr size_t dataSize = count * sizeof(uint32_t);
+    Buffer buffer = manager.createBuffer(dataSize);
+    Task task = manager.createTask("../examples/shaders/fibonacci.spv", (uint32_t)count);
+    uint32_t data[count] = {1, 2, 3, 4, 5};
+    uint32_t result[count];
+
+    Job job = manager.createJob();
+    job.syncResourceToDevice(buffer, data, dataSize)
+        .addTask(task, {{ &buffer }}, count)
+        .syncResourceToHost(buffer, result, dataSize)
+        .submit();
+    REQUIRE(job.await());
+
+    SECTION("Tasks measured")
+    {
+        const auto &records = job.getProfilingResults();
+        REQUIRE(records.size() >= 1);
+        auto taskRecord = std::find_if(records.begin(), records.end(), [](const ProfilingRecord &record) {
+            return record.category == "task";
+        });
+        REQUIRE(taskRecord != records.end());
+        REQUIRE(taskRecord->name == "fibonacci");
+        REQUIRE(taskRecord->duration >= 0);
+        if (manager.isPipelineStatisticsEnabled())
+            REQUIRE(taskRecord->invocations > 0);
+    }
+
+    SECTION("Named tasks")
+    {
+        job.reset();
+        task.setName("first");
+        job.addTask(task, {{ &buffer }}, count);
+        task.setName("second");
+        job.addTask(task, {{ &buffer }}, count)
+            .submit();
+        REQUIRE(job.await());
+
+        const auto &records = job.getProfilingResults();
+        REQUIRE(records.size() == 2);
+        REQUIRE(records[0].name == "first");
+        REQUIRE(records[1].name == "second");
+    }
+
+    SECTION("Resubmitted")
+    {
+        size_t recordCount = job.getProfilingResults().size();
+        job.submit();
+        REQUIRE(job.await());
+        REQUIRE(job.getProfilingResults().size() == recordCount);
+    }
+
+    SECTION("Chrome trace written")
+    {
+        std::ostringstream os;
+        writeChromeTrace(os, job.getProfilingResults());
+        REQUIRE(os.str().find("\"traceEvents\"") != std::string::npos);
+        REQUIRE(os.str().find("\"fibonacci\"") != std::string::npos);
+    }
+}
+
+TEST_CASE("Job buffer device address tests", "[Job]")
+{
+    JobManagerSettings settings;
+    settings.enableBufferDeviceAddress = true;
+    JobManager manager({}, nullptr, settings);
+    if (!manager.supportsBufferDeviceAddress())
+        return;
+
+    constexpr size_t count = 4;
+    constexpr size_t dataSize = count * sizeof(uint32_t);
+    Buffer buffer = manager.createBuffer(2 * dataSize);
+    REQUIRE(buffer.getDeviceAddress() != 0);
+    REQUIRE(manager.createBuffer(dataSize, Buffer::Type::Staging).getDeviceAddress() == 0);
+
+    Buffer values(buffer, dataSize, dataSize);
+    REQUIRE(values.getDeviceAddress() == buffer.getDeviceAddress() + dataSize);
+
+    SECTION("Buffer accessed through push constants")
+    {
+        Task task = manager.createTask("../examples/shaders/scale_address.spv");
+        uint32_t data[count] = {1, 2, 3, 4};
+        uint32_t expected[count] = {3, 6, 9, 12};
+
+        // std430 layout of the push constants: 8-byte address followed by the factor
+        char constants[sizeof(VkDeviceAddress) + sizeof(uint32_t)];
+        VkDeviceAddress address = values.getDeviceAddress();
+        uint32_t factor = 3;
+        std::memcpy(constants, &address, sizeof(address));
+        std::memcpy(constants + sizeof(address), &factor, sizeof(factor));
+
+        Job job = manager.createJob();
+        job.syncResourceToDevice(values, data, dataSize)
+            .pushConstants(constants, sizeof(constants))
+            .useBufferAddresses({ &values })
+            .addTask(task, count)
+            .syncResourceToHost(values, data, dataSize)
+            .submit();
+        REQUIRE(job.await());
+
+        REQUIRE(std::equal(data, data + count, expected));
+    }
+
+    SECTION("Buffer without address rejected")
+    {
+        JobManager plainManager;
+        Buffer plainBuffer = plainManager.createBuffer(dataSize);
+        Job job = plainManager.createJob();
+        REQUIRE_THROWS(job.useBufferAddresses({ &plainBuffer }));
+    }
+}
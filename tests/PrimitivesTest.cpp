@@ -0,0 +1,112 @@
+#include "catch.hpp"
+
+#include "Primitives.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+
+TEST_CASE("Primitives tests", "[Primitives]")
+{
+    JobManager manager;
+    Primitives primitives(manager);
+    Job job = manager.createJob();
+
+    REQUIRE(primitives.getWorkgroupSize() >= 16);
+    if (primitives.usesSubgroups())
+        REQUIRE(primitives.getWorkgroupSize() >= manager.getComputeLimits().subgroupSize);
+
+    // large enough for several levels of block sums
+    auto count = GENERATE(as<uint32_t>(), 1, 1000, 70000);
+    const size_t dataSize = count * sizeof(uint32_t);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint32_t> dis(0, 255);
+    std::vector<uint32_t> data(count);
+    for (auto &value : data)
+        value = dis(gen);
+
+    Buffer input = manager.createBuffer(dataSize);
+    Buffer output = manager.createBuffer(dataSize);
+    job.syncResourceToDevice(input, data.data(), dataSize);
+
+    SECTION("Reduce")
+    {
+        uint32_t sum = 0;
+        primitives.reduce(job, input, output, count)
+            .syncResourceToHost(output, &sum, sizeof(uint32_t))
+            .submit();
+        REQUIRE(job.await());
+
+        REQUIRE(sum == std::accumulate(data.begin(), data.end(), 0u));
+    }
+
+    SECTION("Exclusive scan")
+    {
+        std::vector<uint32_t> result(count);
+        primitives.exclusiveScan(job, input, output, count)
+            .syncResourceToHost(output, result.data(), dataSize)
+            .submit();
+        REQUIRE(job.await());
+
+        std::vector<uint32_t> expected(count);
+        std::exclusive_scan(data.begin(), data.end(), expected.begin(), 0u);
+        REQUIRE(result == expected);
+    }
+
+    SECTION("Sort")
+    {
+        // keys spread over all digits
+        std::uniform_int_distribution<uint32_t> keyDis;
+        for (auto &value : data)
+            value = keyDis(gen);
+        job.setUploadData(input, data.data());
+
+        std::vector<uint32_t> result(count);
+        primitives.sort(job, input, count)
+            .syncResourceToHost(input, result.data(), dataSize)
+            .submit();
+        REQUIRE(job.await());
+
+        std::sort(data.begin(), data.end());
+        REQUIRE(result == data);
+    }
+
+    SECTION("Compact")
+    {
+        std::vector<uint32_t> result(count);
+        uint32_t keptCount = 0;
+        Buffer outputCount = manager.createBuffer(sizeof(uint32_t));
+        primitives.compact(job, input, input, output, outputCount, count)
+            .syncResourceToHost(output, result.data(), dataSize)
+            .syncResourceToHost(outputCount, &keptCount, sizeof(uint32_t))
+            .submit();
+        REQUIRE(job.await());
+
+        std::vector<uint32_t> expected;
+        std::copy_if(data.begin(), data.end(), std::back_inserter(expected), [](uint32_t value) { return value != 0; });
+        REQUIRE(keptCount == expected.size());
+        REQUIRE(std::equal(expected.begin(), expected.end(), result.begin()));
+    }
+
+    SECTION("Histogram")
+    {
+        // values of the last quarter are ignored
+        constexpr uint32_t binCount = 192;
+        std::vector<uint32_t> result(binCount);
+        Buffer bins = manager.createBuffer(binCount * sizeof(uint32_t));
+        primitives.histogram(job, input, bins, count, binCount)
+            .syncResourceToHost(bins, result.data(), binCount * sizeof(uint32_t))
+            .submit();
+        REQUIRE(job.await());
+
+        std::vector<uint32_t> expected(binCount, 0);
+        for (uint32_t value : data)
+        {
+            if (value < binCount)
+                ++expected[value];
+        }
+        REQUIRE(result == expected);
+    }
+}
@@ -14,6 +14,12 @@ static std::string resourceTypeName(ResourceType type)
     {
         C(StorageBuffer);
         C(StorageImage);
+        C(SampledImage);
+        C(UniformBuffer);
+        C(StorageBufferDynamic);
+        C(UniformBufferDynamic);
+        C(UniformTexelBuffer);
+        C(StorageTexelBuffer);
         D(none);
     }
 }
@@ -28,6 +34,7 @@ static std::string bufferTypeName(Buffer::Type type)
         C(DeviceLocal);
         C(Staging);
         C(Uniform);
+        C(DeviceMapped);
         D(none);
     }
 }